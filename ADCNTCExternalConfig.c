@@ -4,18 +4,31 @@
 #define ADC_NTC_CHANNEL ADC10INCH_1
 #define START_BYTE 255
 
+// Sampling period in SMCLK ticks (40000 = 40 ms = 25 Hz at 1 MHz).
+// Timer_A0 output TA0.1 starts each conversion in hardware, so the period can be
+// shortened down to one conversion time (16 sample + 12 conversion ADC10CLK cycles)
+#define SAMPLE_PERIOD 40000
+#define TRIGGERS_PER_SAMPLE 1          // One conversion per sample
+
 unsigned int adc_value;  // Store raw 10-bit ADC result
-unsigned char temperature;  // Store 8-bit temperature result
-volatile unsigned char transmit = 0;   // Flag to trigger data transmission
+
+// One timestamped temperature sample
+struct sample {
+    unsigned long timestamp;           // SMCLK ticks since start-up
+    unsigned char temperature;         // 8-bit temperature result
+    unsigned char rate_shift;          // Sample rate when it was taken
+};
+
+#include "AdcSampling.h"            // Trigger, sample FIFO and status packets
 
 // Function Prototypes
 void configure_UART();
 void configure_ADC10();
-void configure_timer_interrupt();
 void configure_p2_7();
-void transmit_data();
+void transmit_data(const struct sample *record);
+void fifo_push(unsigned char temperature);
 void clkInit();
-unsigned char sampleADC(unsigned int channel);
+void configure_LEDs();
 void update_LEDs(unsigned char temp);
 
 // Function to configure UART with correct baud rate and settings
@@ -35,15 +48,21 @@ void configure_UART() {
 // Function to configure ADC for sampling temperature sensor (NTC)
 void configure_ADC10() {
     ADC10CTL0 = ADC10SHT_2 | ADC10ON;  // Sample and hold time = 16 ADC10CLK cycles, ADC on
-    ADC10CTL1 = ADC10SHP | ADC10SSEL_3; // Use sampling timer, SMCLK source
+    ADC10CTL1 = ADC10_TRIGGER | ADC10SHP | ADC10SSEL_3; // Trigger on TA0.1 (or ADC10SC), sampling timer, SMCLK
     ADC10CTL2 = ADC10RES;              // 10-bit resolution
+    ADC10MCTL0 = ADC_NTC_CHANNEL;      // Select the channel (NTC sensor)
+    ADC10IE = ADC10IE0;                // Interrupt when a conversion result is ready
+    ADC10CTL0 |= ADC10ENC;             // Enable conversions, the timer starts each one
 }
 
-// Function to configure Timer A for periodic interrupts (every 40 ms, 25 Hz)
-void configure_timer_interrupt() {
-    TA0CCR0 = 40000 - 1;               // Timer period for 40 ms (SMCLK 1 MHz / 25Hz)
-    TA0CCTL0 = CCIE;                   // Enable Timer A interrupt
-    TA0CTL = TASSEL_2 | MC_1 | TACLR;  // SMCLK, up mode, clear timer
+// Push a sample record (called from the ADC ISR only)
+void fifo_push(unsigned char temperature) {
+    struct sample *record = fifo_claim();
+
+    if (record) {
+        record->temperature = temperature;
+        fifo_publish(record);
+    }
 }
 
 // Function to power the NTC sensor via P2.7
@@ -53,65 +72,75 @@ void configure_p2_7() {
 }
 
 // Function to transmit temperature data via UART
-void transmit_data() {
+void transmit_data(const struct sample *record) {
     transmitChar(START_BYTE);           // Transmit start byte (255)
-    transmitChar(temperature);          // Transmit temperature data
+    transmitChar(record->temperature < DATA_MAX ? record->temperature : DATA_MAX); // Transmit temperature data
 }
 
-// Helper function to transmit a character via UART
-void transmitChar(unsigned char data) {
-    while (!(UCA0IFG & UCTXIFG));       // Wait for transmit buffer to be ready
-    UCA0TXBUF = data;                   // Transmit character
-}
-
-// Function to sample ADC for given channel (NTC)
-unsigned char sampleADC(unsigned int channel) {
-    ADC10CTL0 &= ~ADC10ENC;            // Disable ADC before changing channels
-    ADC10MCTL0 = channel;              // Select the channel (NTC sensor)
-    ADC10CTL0 |= ADC10ENC | ADC10SC;   // Enable and start conversion
-    while (ADC10CTL1 & ADC10BUSY);     // Wait until conversion completes
-    return ADC10MEM0 >> 2;             // Return 8-bit result (shifted 10-bit)
-}
-
-// Function to update LEDs based on temperature value
-void update_LEDs(unsigned char temp) {
+// Function to configure the LED pins once at startup
+void configure_LEDs() {
     // Set P3.4 to P3.7 and PJ.0 to PJ.3 as outputs for the LEDs
     PJDIR |= (BIT0 | BIT1 | BIT2 | BIT3);    // PJ.0 - PJ.3 as output
     P3DIR |= (BIT4 | BIT5 | BIT6 | BIT7);    // P3.4 - P3.7 as output
 
     PJOUT &= ~(BIT0 | BIT1 | BIT2 | BIT3);   // Turn off all PJ LEDs
     P3OUT &= ~(BIT4 | BIT5 | BIT6 | BIT7);   // Turn off all P3 LEDs
+}
+
+// Function to update LEDs based on temperature value
+void update_LEDs(unsigned char temp) {
+    unsigned char pj_leds;                    // LED1 to LED4 pattern (PJ.0 to PJ.3)
+    unsigned char p3_leds;                    // LED5 to LED8 pattern (P3.4 to P3.7)
 
-    // Light up LEDs based on temperature value
+    // Pick the LED pattern based on temperature value
     if (temp > 190) {
-        PJOUT |= BIT0; // LED1 (PJ.0)
+        pj_leds = BIT0; // LED1 (PJ.0)
+        p3_leds = 0;
     } else if (temp > 189) {
-        PJOUT |= BIT0 | BIT1; // LED1 & LED2 (PJ.0, PJ.1)
+        pj_leds = BIT0 | BIT1; // LED1 & LED2 (PJ.0, PJ.1)
+        p3_leds = 0;
     } else if (temp > 188) {
-        PJOUT |= BIT0 | BIT1 | BIT2; // LED1 to LED3 (PJ.0, PJ.1, PJ.2)
+        pj_leds = BIT0 | BIT1 | BIT2; // LED1 to LED3 (PJ.0, PJ.1, PJ.2)
+        p3_leds = 0;
     } else if (temp > 185) {
-        PJOUT |= BIT0 | BIT1 | BIT2 | BIT3; // LED1 to LED4 (PJ.0 to PJ.3)
+        pj_leds = BIT0 | BIT1 | BIT2 | BIT3; // LED1 to LED4 (PJ.0 to PJ.3)
+        p3_leds = 0;
     } else if (temp > 182) {
-        PJOUT |= BIT0 | BIT1 | BIT2 | BIT3; // PJ LEDs
-        P3OUT |= BIT4; // LED5 (P3.4)
+        pj_leds = BIT0 | BIT1 | BIT2 | BIT3; // PJ LEDs
+        p3_leds = BIT4; // LED5 (P3.4)
     } else if (temp > 180) {
-        PJOUT |= BIT0 | BIT1 | BIT2 | BIT3; // PJ LEDs
-        P3OUT |= BIT4 | BIT5; // LED5 & LED6 (P3.4, P3.5)
+        pj_leds = BIT0 | BIT1 | BIT2 | BIT3; // PJ LEDs
+        p3_leds = BIT4 | BIT5; // LED5 & LED6 (P3.4, P3.5)
     } else if (temp > 179) {
-        PJOUT |= BIT0 | BIT1 | BIT2 | BIT3; // PJ LEDs
-        P3OUT |= BIT4 | BIT5 | BIT6; // LED5 to LED7 (P3.4 to P3.6)
+        pj_leds = BIT0 | BIT1 | BIT2 | BIT3; // PJ LEDs
+        p3_leds = BIT4 | BIT5 | BIT6; // LED5 to LED7 (P3.4 to P3.6)
     } else {
-        PJOUT |= BIT0 | BIT1 | BIT2 | BIT3; // PJ LEDs
-        P3OUT |= BIT4 | BIT5 | BIT6 | BIT7; // All LEDs on
+        pj_leds = BIT0 | BIT1 | BIT2 | BIT3; // PJ LEDs
+        p3_leds = BIT4 | BIT5 | BIT6 | BIT7; // All LEDs on
     }
+
+    // Write each port once instead of clearing and then setting the LEDs
+    PJOUT = (PJOUT & ~(BIT0 | BIT1 | BIT2 | BIT3)) | pj_leds;
+    P3OUT = (P3OUT & ~(BIT4 | BIT5 | BIT6 | BIT7)) | p3_leds;
 }
 
-// Timer A0 ISR (triggered every 40 ms)
-#pragma vector = TIMER0_A0_VECTOR
-__interrupt void Timer_A_ISR(void) {
-    temperature = sampleADC(ADC_NTC_CHANNEL);  // Sample temperature from NTC sensor
-    update_LEDs(temperature);                  // Update LED display based on temperature
-    transmit = 1;                              // Set transmit flag
+// ADC10 ISR (triggered when a timer-started conversion completes)
+#pragma vector = ADC10_VECTOR
+__interrupt void ADC10_ISR(void) {
+    switch (__even_in_range(ADC10IV, ADC10IV_ADC10IFG)) {
+        case ADC10IV_ADC10IFG:
+        {
+            record_latency();                          // Time since the trigger at CCR0
+            unsigned char temperature = ADC10MEM0 >> 2; // 8-bit result (shifted 10-bit), clears ADC10IFG0
+            update_LEDs(temperature);                  // Update LED display based on temperature
+            fifo_push(temperature);                    // Queue the sample for main
+            sample_time += next_trigger_ticks();       // Time of the next trigger
+            __bic_SR_register_on_exit(LPM0_bits);      // Wake main to send the result
+        }
+            break;
+        default:
+            break;
+    }
 }
 
 // Clock initialization (SMCLK = 1 MHz)
@@ -128,16 +157,21 @@ int main(void) {
 
     clkInit();                        // Initialize clocks
     configure_p2_7();                 // Power NTC sensor using P2.7
+    configure_LEDs();                 // Set up the temperature bar LEDs
     configure_ADC10();                // Set up ADC for NTC sensor
     configure_UART();                 // Set up UART for 9600 baud
-    configure_timer_interrupt();      // Set up Timer A interrupt
+    configure_timer_trigger();        // Set up Timer A to trigger the ADC
 
     __bis_SR_register(GIE);           // Enable global interrupts
 
     while (1) {
-        if (transmit == 1) {          // Check if transmit flag is set
-            transmit_data();          // Transmit data via UART
-            transmit = 0;             // Clear transmit flag
+        __disable_interrupt();        // Check the FIFO with interrupts off so no wake-up is missed
+        if (fifo_head == fifo_tail) {
+            __bis_SR_register(LPM0_bits | GIE); // Sleep until the ADC ISR has a new result
+        } else {
+            __enable_interrupt();
         }
+
+        drain_samples();              // Transmit all queued samples via UART
     }
 }
@@ -0,0 +1,400 @@
+#include "msp430fr5739.h"
+
+// Define the data packet start byte. Sample bytes are capped at DATA_MAX so only
+// a start byte can begin a packet
+#define START_BYTE 255
+#define DATA_MAX (START_BYTE - 1)
+
+// Scheduler time base: one conversion slot every SLOT_PERIOD SMCLK ticks (1 kHz at 1 MHz).
+// Timer_A0 output TA0.1 triggers every conversion, so the CPU only runs to collect results
+#define SLOT_PERIOD 1000
+#define SLOT_HZ (1000000UL / SLOT_PERIOD)
+#define ADC_CONVERSION_TICKS 28             // 16 sample + 12 conversion ADC10CLK cycles
+#define ADC_ISR_TICKS 100                   // Headroom for the ADC ISR to set up the next slot
+
+#if SLOT_PERIOD < ADC_CONVERSION_TICKS + ADC_ISR_TICKS
+#error "SLOT_PERIOD is shorter than one ADC10 conversion plus the ADC ISR"
+#endif
+
+#define MAX_SCHEDULE 512                    // Most conversions per hyperperiod (the table lives in FRAM)
+#define MAX_CYCLE_SLOTS (65536UL / SLOT_PERIOD) // Longest Timer_A0 cycle in slots; longer gaps take several
+#define MAX_OVERSAMPLE 64                   // Keeps the sum of 10-bit conversions within 16 bits
+#define CHANNEL_COUNT 4
+
+// Schedule errors, reported on the UART as START_BYTE, 0xEE, error, channel
+#define SCHED_OK 0
+#define SCHED_ERR_RATE 1                    // Rate of 0, oversampling above 64, or more conversions than slots
+#define SCHED_ERR_LENGTH 2                  // Hyperperiod needs more than MAX_SCHEDULE conversions
+#define SCHED_ERR_UTILIZATION 3             // More conversions than slots in the hyperperiod
+#define SCHED_ERR_DEADLINE 4                // Rate-monotonic order misses a conversion deadline
+
+// Report packet types (START_BYTE, type, high byte, low byte)
+#define REPORT_CHANNEL_RATE 0xF0            // 0xF0 + channel: achieved rate in 1/10 Hz
+#define REPORT_UTILIZATION 0xFE             // ADC utilization in 1/1000
+#define REPORT_ERROR 0xEE
+
+// Output FIFO between the ADC ISR and main (power of two so indexes wrap with a mask)
+#define OUTPUT_SIZE 32
+#define OUTPUT_MASK (OUTPUT_SIZE - 1)
+
+// One sensor channel and its requirements
+struct adc_channel {
+    unsigned int inch;                      // ADC10 input channel
+    unsigned int rate_hz;                   // Requested output sample rate
+    unsigned char oversample;               // Conversions averaged into each output sample
+    unsigned int period;                    // Slots between conversions (computed at startup)
+    unsigned int sum;                       // Running sum of the current output sample
+    unsigned char conversions;              // Conversions in the current output sample
+};
+
+// One scheduled conversion
+struct schedule_entry {
+    unsigned char channel;                  // Channel converted in this slot
+    unsigned int gap;                       // Slots until the next scheduled conversion
+};
+
+// One averaged output sample
+struct output_sample {
+    unsigned char channel;                  // Channel index
+    unsigned int sum;                       // Sum of 'oversample' 10-bit conversions
+};
+
+// Channel requirements. Both sensors are powered from P2.7
+struct adc_channel channels[CHANNEL_COUNT] = {
+    { ADC10INCH_12, 100, 1 },               // Accelerometer X-axis (A12), 100 Hz
+    { ADC10INCH_13, 100, 1 },               // Accelerometer Y-axis (A13), 100 Hz
+    { ADC10INCH_14, 100, 1 },               // Accelerometer Z-axis (A14), 100 Hz
+    { ADC10INCH_1,  5,   4 },               // NTC temperature (A1), 5 Hz averaged over 4 conversions
+};
+
+// Schedule variables. The table is too big for the 1 KB of RAM, so it is kept
+// in FRAM and rebuilt at every start-up
+#pragma PERSISTENT(schedule)
+struct schedule_entry schedule[MAX_SCHEDULE] = { { 0, 0 } };
+unsigned int schedule_length = 0;           // Scheduled conversions per hyperperiod
+unsigned long hyperperiod = 1;              // Slots before the schedule repeats
+unsigned int utilization = 0;               // Fraction of slots converting, in 1/1000
+unsigned char schedule_error_channel = 0;   // Channel that made the schedule infeasible
+unsigned int current_entry = 0;             // Entry whose conversion is in progress
+unsigned int wait_slots = 0;                // Slots of the current gap left after this timer cycle
+
+// Output FIFO variables (single producer ISR, single consumer main)
+struct output_sample output_fifo[OUTPUT_SIZE];
+volatile unsigned char output_head = 0;     // Next sample to write, only advanced by the ADC ISR
+volatile unsigned char output_tail = 0;     // Next sample to read, only advanced by main
+volatile unsigned int output_overruns = 0;  // Samples dropped because the FIFO was full
+
+// Function Prototypes
+void configure_UART();
+void configure_ADC10();
+void configure_timer_trigger();
+void configure_p2_7();
+void configure_LED1();
+void clkInit();
+unsigned int gcd(unsigned int a, unsigned int b);
+unsigned char build_schedule();
+void start_cycle(unsigned int slots);
+void report_schedule();
+void report_error(unsigned char error);
+void transmit_packet(unsigned char type, unsigned int value);
+void transmit_samples();
+void transmitChar(unsigned char data);
+
+// Function to configure UART with correct baud rate and settings
+void configure_UART() {
+    // Select SMCLK for UART and configure UART pins
+    P2SEL0 &= ~(BIT0 | BIT1);
+    P2SEL1 |= (BIT0 | BIT1);
+
+    UCA0CTLW0 |= UCSWRST;              // Put UART in reset mode
+    UCA0CTLW0 |= UCSSEL__SMCLK;        // Use SMCLK (1 MHz after division)
+
+    UCA0BRW = 104;                     // Set baud rate for 9600 (SMCLK 1 MHz)
+    UCA0MCTLW = 0xD600;                // Set modulation UCBRSx=0xD6, UCOS16=1
+
+    UCA0CTLW0 &= ~UCSWRST;             // Release UART from reset
+}
+
+// Function to configure ADC for timer-triggered conversions of the first scheduled channel
+void configure_ADC10() {
+    ADC10CTL0 = ADC10SHT_2 | ADC10ON;  // Sample and hold time = 16 ADC10CLK cycles, ADC on
+    ADC10CTL1 = ADC10SHS_1 | ADC10SHP | ADC10SSEL_3 | ADC10CONSEQ_2; // Trigger on TA0.1, sampling timer, SMCLK, repeat single channel
+    ADC10CTL2 = ADC10RES;              // 10-bit resolution
+    ADC10MCTL0 = channels[schedule[0].channel].inch; // First scheduled channel
+    ADC10IE = ADC10IE0;                // Interrupt when a conversion result is ready
+    ADC10CTL0 |= ADC10ENC;             // Enable conversions, the timer starts each one
+}
+
+// Function to configure Timer A to trigger the first scheduled conversion one slot from now.
+// Each timer cycle spans the gap to the next scheduled conversion, so idle slots cost nothing
+void configure_timer_trigger() {
+    TA0CCR0 = SLOT_PERIOD - 1;         // First cycle: one slot
+    TA0CCR1 = 1;                       // TA0.1 falls here...
+    TA0CCTL1 = OUTMOD_7;               // ...and rises at CCR0, so each conversion ends a cycle
+    TA0CTL = TASSEL_2 | MC_1 | TACLR;  // SMCLK, up mode, clear timer
+}
+
+// Set the length of the timer cycle that has just started, given the slots to
+// the next conversion. Called from the ISRs early in the cycle, a whole cycle
+// before its trigger. A gap longer than one timer cycle is split: its cycles
+// end with ADC10ENC clear, so their triggers are ignored, and the CCR0 interrupt
+// starts the next one
+void start_cycle(unsigned int slots) {
+    if (slots > MAX_CYCLE_SLOTS) {
+        wait_slots = slots - MAX_CYCLE_SLOTS;
+        TA0CCR0 = MAX_CYCLE_SLOTS * SLOT_PERIOD - 1;
+        ADC10CTL0 &= ~ADC10ENC;        // No conversion at the end of this cycle
+        TA0CCTL0 = CCIE;               // Continue the gap when it ends (clears the stale CCIFG)
+    } else {
+        wait_slots = 0;
+        TA0CCR0 = slots * SLOT_PERIOD - 1;
+        ADC10CTL0 |= ADC10ENC;         // Convert at the end of this cycle
+        TA0CCTL0 = 0;
+    }
+}
+
+// Function to power the accelerometer and NTC sensor via P2.7
+void configure_p2_7() {
+    P2DIR |= BIT7;                     // Set P2.7 as output
+    P2OUT |= BIT7;                     // Set P2.7 high to power the sensors
+}
+
+// Function to configure LED1 (PJ.0) as the schedule error indicator
+void configure_LED1() {
+    PJDIR |= BIT0;                     // Set PJ.0 as output for LED1
+    PJOUT &= ~BIT0;                    // Initialize LED1 as off
+}
+
+// Greatest common divisor, used to find the hyperperiod
+unsigned int gcd(unsigned int a, unsigned int b) {
+    while (b != 0) {
+        unsigned int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Compute a conflict-free conversion schedule for all channels.
+// Each conversion must run before the channel's next one is due, and channels with
+// shorter periods always win a slot (rate-monotonic priority)
+unsigned char build_schedule() {
+    unsigned char order[CHANNEL_COUNT];          // Channel indexes, shortest period first
+    unsigned char pending[CHANNEL_COUNT];        // Conversion released but not yet scheduled
+    unsigned long release[CHANNEL_COUNT];        // Next slot each channel's conversion is due
+    unsigned long conversions = 0;               // Conversions needed per hyperperiod
+    unsigned long slot, first_slot = 0, last_slot = 0;
+    unsigned int i, j;
+
+    hyperperiod = 1;
+
+    // Period of each channel in slots, and the hyperperiod they all repeat in.
+    // Every channel converts at least once every SLOT_HZ slots, so a hyperperiod
+    // longer than MAX_SCHEDULE * SLOT_HZ can't fit the table (and stays in 32 bits)
+    for (i = 0; i < CHANNEL_COUNT; i++) {
+        unsigned long per_second = (unsigned long)channels[i].rate_hz * channels[i].oversample;
+        schedule_error_channel = i;
+        if (per_second == 0 || per_second > SLOT_HZ || channels[i].oversample > MAX_OVERSAMPLE) return SCHED_ERR_RATE;
+
+        channels[i].period = SLOT_HZ / per_second;  // Rounded down, so the achieved rate is never lower
+
+        // gcd(H, period) = gcd(H mod period, period), which stays in 16 bits
+        hyperperiod = hyperperiod / gcd(hyperperiod % channels[i].period, channels[i].period) * channels[i].period;
+        if (hyperperiod > (unsigned long)MAX_SCHEDULE * SLOT_HZ) return SCHED_ERR_LENGTH;
+    }
+
+    for (i = 0; i < CHANNEL_COUNT; i++) {
+        conversions += hyperperiod / channels[i].period;
+    }
+    schedule_error_channel = CHANNEL_COUNT - 1;
+    if (conversions > hyperperiod) return SCHED_ERR_UTILIZATION;
+    if (conversions > MAX_SCHEDULE) return SCHED_ERR_LENGTH;
+
+    // Rate-monotonic priority order (insertion sort by period)
+    for (i = 0; i < CHANNEL_COUNT; i++) {
+        j = i;
+        while (j > 0 && channels[order[j - 1]].period > channels[i].period) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+        pending[i] = 0;
+        release[i] = 0;
+    }
+
+    // Simulate one hyperperiod, one conversion per slot, skipping straight to the
+    // next release when nothing is pending. Slot 'hyperperiod' is slot 0 of the
+    // next round, so every deadline is checked
+    schedule_length = 0;
+    slot = 0;
+    for (;;) {
+        unsigned long next_release = hyperperiod;
+        unsigned char busy = 0;
+
+        for (i = 0; i < CHANNEL_COUNT; i++) {
+            if (release[i] == slot) {
+                schedule_error_channel = i;
+                if (pending[i]) return SCHED_ERR_DEADLINE; // Previous conversion never got a slot
+                pending[i] = 1;
+                release[i] += channels[i].period;
+            }
+            if (release[i] < next_release) next_release = release[i];
+        }
+        if (slot == hyperperiod) break;
+
+        for (i = 0; i < CHANNEL_COUNT; i++) {
+            unsigned char channel = order[i];
+            if (pending[channel]) {
+                pending[channel] = 0;
+                if (schedule_length > 0) {
+                    schedule[schedule_length - 1].gap = slot - last_slot;
+                } else {
+                    first_slot = slot;
+                }
+                schedule[schedule_length].channel = channel;
+                schedule_length++;
+                last_slot = slot;
+                break;
+            }
+        }
+        for (i = 0; i < CHANNEL_COUNT; i++) {
+            busy |= pending[i];
+        }
+        slot = busy ? slot + 1 : next_release;    // Idle slots until the next release
+    }
+
+    // The last conversion's gap wraps into the next hyperperiod
+    schedule[schedule_length - 1].gap = first_slot + hyperperiod - last_slot;
+
+    utilization = (unsigned long)schedule_length * 1000 / hyperperiod;
+    return SCHED_OK;
+}
+
+// Report the achieved rate of every channel and the ADC utilization
+void report_schedule() {
+    unsigned int i;
+    for (i = 0; i < CHANNEL_COUNT; i++) {
+        unsigned int decihertz = SLOT_HZ * 10 / ((unsigned long)channels[i].period * channels[i].oversample);
+        transmit_packet(REPORT_CHANNEL_RATE + i, decihertz);
+    }
+    transmit_packet(REPORT_UTILIZATION, utilization);
+}
+
+// Report an infeasible configuration and stop with LED1 on
+void report_error(unsigned char error) {
+    transmit_packet(REPORT_ERROR, ((unsigned int)error << 8) | schedule_error_channel);
+    PJOUT |= BIT0;                     // Turn on LED1 to flag the error
+    while (1) {
+        __bis_SR_register(LPM4_bits);  // Nothing more to do
+    }
+}
+
+// Transmit a report packet (start byte, type, value high byte, value low byte)
+void transmit_packet(unsigned char type, unsigned int value) {
+    transmitChar(START_BYTE);
+    transmitChar(type);
+    transmitChar(value >> 8);
+    transmitChar(value & 0xFF);
+}
+
+// Send every completed sample (start byte, channel, 8-bit average)
+void transmit_samples() {
+    while (output_head != output_tail) {
+        struct output_sample *sample = &output_fifo[output_tail & OUTPUT_MASK];
+        unsigned char average = (sample->sum / channels[sample->channel].oversample) >> 2;
+        transmitChar(START_BYTE);
+        transmitChar(sample->channel);
+        transmitChar(average < DATA_MAX ? average : DATA_MAX);
+        output_tail++;                // Free the slot only after it has been sent
+    }
+}
+
+// Helper function to transmit a character via UART
+void transmitChar(unsigned char data) {
+    while (!(UCA0IFG & UCTXIFG));       // Wait for transmit buffer to be ready
+    UCA0TXBUF = data;                   // Transmit character
+}
+
+// ADC10 ISR (triggered when a timer-started conversion completes)
+#pragma vector = ADC10_VECTOR
+__interrupt void ADC10_ISR(void) {
+    switch (__even_in_range(ADC10IV, ADC10IV_ADC10IFG)) {
+        case ADC10IV_ADC10IFG:
+        {
+            struct schedule_entry *entry = &schedule[current_entry];
+            struct adc_channel *channel = &channels[entry->channel];
+
+            // Select the channel for the next scheduled conversion
+            if (++current_entry == schedule_length) current_entry = 0;
+            ADC10CTL0 &= ~ADC10ENC;             // Disable ADC before changing channels
+            ADC10MCTL0 = channels[schedule[current_entry].channel].inch;
+
+            // The current timer cycle ends at the next scheduled conversion (re-arms the ADC)
+            start_cycle(entry->gap);
+
+            channel->sum += ADC10MEM0;          // Accumulate the 10-bit result
+            if (++channel->conversions == channel->oversample) {
+                if ((unsigned char)(output_head - output_tail) >= OUTPUT_SIZE) {
+                    output_overruns++;          // No room: count the lost sample
+                } else {
+                    struct output_sample *sample = &output_fifo[output_head & OUTPUT_MASK];
+                    sample->channel = entry->channel;
+                    sample->sum = channel->sum;
+                    output_head++;              // Publish the sample once it is complete
+                }
+                channel->sum = 0;
+                channel->conversions = 0;
+                __bic_SR_register_on_exit(LPM0_bits); // Wake main to send the sample
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Timer A0 CCR0 ISR (only enabled while a gap spans several timer cycles)
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void Gap_Timer_ISR(void) {
+    start_cycle(wait_slots);           // Next part of the gap
+}
+
+// Clock initialization (SMCLK = 1 MHz)
+void clkInit() {
+    CSCTL0 = 0xA500;                  // Write password to modify CS registers
+    CSCTL1 = DCOFSEL_3;               // Set DCO to 8 MHz
+    CSCTL2 = SELM__DCOCLK | SELS__DCOCLK | SELA__DCOCLK;  // Set MCLK, SMCLK, ACLK to DCO
+    CSCTL3 = DIVA__8 | DIVS__8;       // Divide SMCLK and ACLK by 8 (1 MHz)
+    CSCTL0_H = 0;                     // Lock CS registers
+}
+
+int main(void) {
+    WDTCTL = WDTPW | WDTHOLD;         // Stop watchdog timer
+
+    clkInit();                        // Initialize clocks
+    configure_LED1();                 // Set up the error LED
+    configure_UART();                 // Set up UART for 9600 baud
+
+    unsigned char error = build_schedule();
+    if (error != SCHED_OK) {
+        report_error(error);          // Reject the configuration, never returns
+    }
+    report_schedule();                // Send achieved rates and ADC utilization
+
+    configure_p2_7();                 // Power the sensors using P2.7
+    configure_ADC10();                // Set up ADC for the first scheduled channel
+    configure_timer_trigger();        // Start the conversion schedule
+
+    __bis_SR_register(GIE);           // Enable global interrupts
+
+    while (1) {
+        __disable_interrupt();        // Check the FIFO with interrupts off so no wake-up is missed
+        if (output_head == output_tail) {
+            __bis_SR_register(LPM0_bits | GIE); // Sleep until a sample is complete
+        } else {
+            __enable_interrupt();
+        }
+
+        transmit_samples();           // Send every completed sample
+    }
+}
@@ -0,0 +1,268 @@
+// Timer-triggered ADC10 sampling shared by the ADC programs: the TA0.1 trigger,
+// the timestamped sample FIFO between the ADC ISR and main, backpressure, and
+// the status packets sent between samples. Include after msp430fr5739.h, once
+// the program has defined:
+//     SAMPLE_PERIOD         trigger period in SMCLK ticks
+//     TRIGGERS_PER_SAMPLE   conversions (triggers) that make up one sample
+//     START_BYTE            first byte of every packet
+//     struct sample         with at least an unsigned long timestamp and an
+//                           unsigned char rate_shift, plus the program's results
+// and provide void transmit_data(const struct sample *record). The functions are
+// static inline, so every program that includes it gets its own copy
+
+#ifndef ADC_SAMPLING_H
+#define ADC_SAMPLING_H
+
+#define ADC_CONVERSION_TICKS 28             // 16 sample + 12 conversion ADC10CLK cycles
+
+#if SAMPLE_PERIOD < ADC_CONVERSION_TICKS
+#error "SAMPLE_PERIOD is shorter than one ADC10 conversion"
+#endif
+
+// Trigger source. 0: the TA0.1 edge starts each conversion in hardware, so the
+// sampling instant does not move. 1: the old software baseline, where the TA0
+// CCR0 ISR sets ADC10SC, kept to measure the sampling-instant jitter that the
+// hardware trigger removes (STATUS_SAMPLE_JITTER)
+#ifndef SOFTWARE_TRIGGER
+#define SOFTWARE_TRIGGER 0
+#endif
+
+#if SOFTWARE_TRIGGER
+#define ADC10_TRIGGER (ADC10SHS_0 | ADC10CONSEQ_0) // ADC10SC, single channel single conversion
+#else
+#define ADC10_TRIGGER (ADC10SHS_1 | ADC10CONSEQ_2) // TA0.1, repeat single channel
+#endif
+
+// Sample FIFO between the ADC ISR and main (power of two so indexes wrap with a mask)
+#define FIFO_SIZE 16
+#define FIFO_MASK (FIFO_SIZE - 1)
+#define FIFO_HIGH_WATER (FIFO_SIZE * 3 / 4) // Fill level that triggers backpressure
+#define FIFO_BACKPRESSURE 1                 // 1 = lower the sample rate instead of dropping samples
+#define MAX_RATE_SHIFT 3                    // Slowest rate is SAMPLE_PERIOD * 8
+
+// The trigger timer's divider is fixed, and a rate change only scales CCR0, so
+// the timer never has to stop and the divider never loses its count. The divider
+// is the smallest one that fits the slowest period in 16 bits. Timing statistics
+// are measured to 1 << TIMER_SHIFT SMCLK ticks
+#if (SAMPLE_PERIOD << MAX_RATE_SHIFT) < 0x10000L
+#define TIMER_SHIFT 0
+#define TIMER_DIVIDER ID__1
+#elif (SAMPLE_PERIOD << MAX_RATE_SHIFT) < 0x20000L
+#define TIMER_SHIFT 1
+#define TIMER_DIVIDER ID__2
+#elif (SAMPLE_PERIOD << MAX_RATE_SHIFT) < 0x40000L
+#define TIMER_SHIFT 2
+#define TIMER_DIVIDER ID__4
+#else
+#define TIMER_SHIFT 3
+#define TIMER_DIVIDER ID__8
+#endif
+
+#if SAMPLE_PERIOD % (1 << TIMER_SHIFT) || (SAMPLE_PERIOD << MAX_RATE_SHIFT >> TIMER_SHIFT) >= 0x10000L
+#error "SAMPLE_PERIOD must be a multiple of the trigger timer divider, and the slowest period must fit in 16 bits"
+#endif
+
+// Trigger timer counts per sample period at a rate shift
+#define TIMER_PERIOD(shift) ((unsigned int)(((unsigned long)SAMPLE_PERIOD << (shift)) >> TIMER_SHIFT))
+
+// Status packets (START_BYTE, START_BYTE, id, upper, lower, escape) are sent
+// between samples. Sample bytes are capped at DATA_MAX so a second start byte
+// can only begin a status packet
+#define DATA_MAX (START_BYTE - 1)
+#define STATUS_PERIOD 25                    // Samples between status packets (1 s at 25 Hz)
+#define STATUS_JITTER 0x01                  // Spread of the trigger-to-result delay in SMCLK ticks
+#define STATUS_TIME_HIGH 0x02               // Upper 16 bits of the next sample's timestamp
+#define STATUS_TIME_LOW 0x03                // Lower 16 bits of the next sample's timestamp
+#define STATUS_RATE 0x04                    // rate_shift from the next sample on
+#define STATUS_OVERRUNS 0x05                // fifo_overruns
+#define STATUS_REDUCTIONS 0x06              // rate_reductions
+#define STATUS_SAMPLE_JITTER 0x07           // Spread of the sampling instant in SMCLK ticks (0 with the hardware trigger)
+#define TRIGGER_TEST_PIN 0                  // 1 = also drive TA0.1 on P1.0 to scope the sampling instants
+
+// Sample FIFO variables (single producer ISR, single consumer main)
+static struct sample sample_fifo[FIFO_SIZE];
+static volatile unsigned char fifo_head = 0;        // Next record to write, only advanced by the ADC ISR
+static volatile unsigned char fifo_tail = 0;        // Next record to read, only advanced by main
+static unsigned long sample_time = SAMPLE_PERIOD - (1 << TIMER_SHIFT); // SMCLK ticks from start-up to the latest trigger (TA0R 0 to CCR0)
+static volatile unsigned int fifo_overruns = 0;     // Samples dropped because the FIFO was full
+static volatile unsigned char rate_shift = 0;       // Sample period is SAMPLE_PERIOD << rate_shift
+static volatile unsigned char requested_shift = 0;  // Rate the ADC ISR switches to after the next trigger
+static unsigned int rate_reductions = 0;            // Times backpressure lowered the sample rate
+
+// Sampling timing: the conversion starts on the TA0.1 edge at CCR0, so TA0R + 1
+// counts in the ADC ISR is the conversion time plus the interrupt latency. Its spread
+// is the jitter between the sampling instant and the result being read
+static unsigned int min_latency = 0xFFFF;           // Shortest delay from the trigger to the ADC ISR
+static unsigned int max_latency = 0;                // Longest delay from the trigger to the ADC ISR
+#if SOFTWARE_TRIGGER
+static unsigned int min_sample_delay = 0xFFFF;      // Shortest delay from CCR0 to ADC10SC
+static unsigned int max_sample_delay = 0;           // Longest delay from CCR0 to ADC10SC
+#endif
+static unsigned char samples_since_status = 0;      // Samples sent since the last status packets
+static unsigned long next_timestamp = 0;            // Timestamp the PC expects for the next sample
+static unsigned char sent_rate = 0;                 // Rate the PC uses for that prediction
+
+void transmit_data(const struct sample *record);
+
+// Function to configure Timer A to trigger the ADC every SAMPLE_PERIOD ticks
+static inline void configure_timer_trigger(void) {
+    TA0CCR0 = TIMER_PERIOD(0) - 1;     // Timer period (40 ms = 25 Hz by default)
+    TA0CCR1 = TIMER_PERIOD(0) / 2;     // TA0.1 falls here...
+    TA0CCTL1 = OUTMOD_7;               // ...and rises at CCR0, right before each rollover
+#if SOFTWARE_TRIGGER
+    TA0CCTL0 = CCIE;                   // Timer_A_ISR starts each conversion instead
+#endif
+    TA0CTL = TASSEL_2 | TIMER_DIVIDER | MC_1 | TACLR; // SMCLK / (1 << TIMER_SHIFT), up mode, clear timer
+
+#if TRIGGER_TEST_PIN
+    P1DIR |= BIT0;                     // TA0.1 on P1.0: one rising edge per sampling instant
+    P1SEL1 &= ~BIT0;
+    P1SEL0 |= BIT0;
+#endif
+}
+
+// Ask for a lower (or restored) sample rate. The ADC ISR applies it at the next
+// trigger so the sampling phase and the timestamps are kept
+static inline void set_rate_shift(unsigned char shift) {
+    requested_shift = shift;
+}
+
+// Ticks from the latest trigger to the next one, switching the trigger period if
+// a new rate was requested. Called from the ADC ISR, after the trigger at CCR0 and
+// the rollover to 0 but long before TA0R reaches CCR1, so the new CCR0 and CCR1
+// take effect for the whole period that has just started
+static inline unsigned long next_trigger_ticks(void) {
+    unsigned char new_shift = requested_shift;
+
+    if (new_shift != rate_shift) {
+        TA0CCR0 = TIMER_PERIOD(new_shift) - 1;
+        TA0CCR1 = TIMER_PERIOD(new_shift) / 2;
+        rate_shift = new_shift;
+    }
+    return (unsigned long)SAMPLE_PERIOD << new_shift;
+}
+
+// Track the delay from the trigger to the ADC ISR (called first thing in the ISR)
+static inline void record_latency(void) {
+    unsigned int latency = (TA0R + 1) << TIMER_SHIFT; // Time since the TA0.1 edge at CCR0, in SMCLK ticks
+    if (latency < min_latency) min_latency = latency;
+    if (latency > max_latency) max_latency = latency;
+}
+
+// Claim the next FIFO record (ADC ISR only). Returns 0 and counts the lost sample if the FIFO is full
+static inline struct sample *fifo_claim(void) {
+    if ((unsigned char)(fifo_head - fifo_tail) >= FIFO_SIZE) {
+        fifo_overruns++;                 // No room: count the lost sample
+        return 0;
+    }
+    return &sample_fifo[fifo_head & FIFO_MASK];
+}
+
+// Stamp a claimed record with the latest trigger and hand it to main
+static inline void fifo_publish(struct sample *record) {
+    record->timestamp = sample_time;
+    record->rate_shift = rate_shift;
+    fifo_head++;                         // Publish the record only once it is complete
+
+#if FIFO_BACKPRESSURE
+    // Main is falling behind: halve the sample rate before any data is lost
+    if ((unsigned char)(fifo_head - fifo_tail) >= FIFO_HIGH_WATER && rate_shift < MAX_RATE_SHIFT) {
+        set_rate_shift(rate_shift + 1);
+        rate_reductions++;
+    }
+#endif
+}
+
+// Helper function to transmit a character via UART
+static inline void transmitChar(unsigned char data) {
+    while (!(UCA0IFG & UCTXIFG));       // Wait for transmit buffer to be ready
+    UCA0TXBUF = data;                   // Transmit character
+}
+
+// Transmit a status packet. Value bytes equal to the start byte are sent as 0
+// with a bit set in the escape byte (bit 0 upper, bit 1 lower)
+static inline void transmit_status(unsigned char id, unsigned int value) {
+    unsigned char upper = value >> 8;
+    unsigned char lower = value & 0xFF;
+    unsigned char escape = 0;
+
+    if (upper == START_BYTE) { upper = 0; escape |= 0x01; }
+    if (lower == START_BYTE) { lower = 0; escape |= 0x02; }
+
+    transmitChar(START_BYTE);
+    transmitChar(START_BYTE);
+    transmitChar(id);
+    transmitChar(upper);
+    transmitChar(lower);
+    transmitChar(escape);
+}
+
+// Transmit the jitter and loss counters as status packets
+static inline void transmit_counters(void) {
+    unsigned int spread, sample_spread = 0, overruns;
+
+    __disable_interrupt();               // Read the ISR's counters from the same moment
+    spread = max_latency - min_latency;
+#if SOFTWARE_TRIGGER
+    sample_spread = max_sample_delay - min_sample_delay;
+#endif
+    overruns = fifo_overruns;
+    __enable_interrupt();
+
+    transmit_status(STATUS_JITTER, spread);
+    transmit_status(STATUS_SAMPLE_JITTER, sample_spread);
+    transmit_status(STATUS_OVERRUNS, overruns);
+    transmit_status(STATUS_REDUCTIONS, rate_reductions);
+}
+
+// Transmit every record in the FIFO as one batch.
+// The PC times each sample as the previous one plus
+// (TRIGGERS_PER_SAMPLE * SAMPLE_PERIOD) << rate. Whenever that would be wrong
+// (a rate change or a lost sample), and every STATUS_PERIOD samples, the exact
+// timestamp and rate are sent first
+static inline void drain_samples(void) {
+    unsigned char fill = (unsigned char)(fifo_head - fifo_tail);
+
+    while (fill--) {
+        const struct sample *record = &sample_fifo[fifo_tail & FIFO_MASK];
+
+        if (samples_since_status == 0) {
+            transmit_counters();
+        }
+        if (samples_since_status == 0 || record->timestamp != next_timestamp || record->rate_shift != sent_rate) {
+            transmit_status(STATUS_TIME_HIGH, record->timestamp >> 16);
+            transmit_status(STATUS_TIME_LOW, record->timestamp & 0xFFFF);
+            transmit_status(STATUS_RATE, record->rate_shift);
+            sent_rate = record->rate_shift;
+        }
+        next_timestamp = record->timestamp + (((unsigned long)TRIGGERS_PER_SAMPLE * SAMPLE_PERIOD) << sent_rate);
+
+        transmit_data(record);
+        fifo_tail++;                     // Free the slot only after it has been sent
+        if (++samples_since_status == STATUS_PERIOD) samples_since_status = 0;
+    }
+
+#if FIFO_BACKPRESSURE
+    // Caught up: step the sample rate back towards SAMPLE_PERIOD
+    __disable_interrupt();
+    if (fifo_head == fifo_tail && rate_shift > 0) {
+        set_rate_shift(rate_shift - 1);
+    }
+    __enable_interrupt();
+#endif
+}
+
+#if SOFTWARE_TRIGGER
+// Software baseline: start each conversion from the CCR0 interrupt. The delay
+// from CCR0 to ADC10SC moves with the interrupt latency, which is the jitter
+// of the sampling instant
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void Timer_A_ISR(void) {
+    unsigned int delay = (TA0R + 1) << TIMER_SHIFT;
+    ADC10CTL0 |= ADC10SC;                // Start the conversion
+    if (delay < min_sample_delay) min_sample_delay = delay;
+    if (delay > max_sample_delay) max_sample_delay = delay;
+}
+#endif
+
+#endif
@@ -1,8 +1,13 @@
 #include "msp430fr5739.h"
 #include "msp430fr57xxgeneric.h"
 
+#include "UartTransport.h"
+
 // Circular buffer parameters
 #define BUFFER_SIZE 50
+#define TX_RESERVE 8                        // TX queue space kept free of 'A's for echoes and error codes
+
+struct uart_port uart;                      // eUSCI_A0 on P2.0/P2.1, 9600 baud
 
 // Circular buffer variables
 unsigned char circular_buffer[BUFFER_SIZE]; // Circular buffer
@@ -14,13 +19,11 @@ volatile unsigned int count = 0;            // Current count of elements in the
 void circular_buffer_add(unsigned char data) {
     if (count < BUFFER_SIZE) {
         circular_buffer[head] = data; // Add the new data
-        head = (head + 1) % BUFFER_SIZE; // Move head pointer
+        if (++head == BUFFER_SIZE) head = 0; // Move head pointer (wrap without a division)
         count++; // Increase the count
     } else {
         // Buffer overrun error
-        while (!(UCA0IFG & UCTXIFG)); // Wait for transmit buffer to be ready
-        UCA0TXBUF = 'E'; // Send error message (example: 'E' for overrun)
-        return 0;
+        uart_write(&uart, 'E'); // Send error message (example: 'E' for overrun)
     }
 }
 
@@ -28,17 +31,32 @@ void circular_buffer_add(unsigned char data) {
 unsigned char circular_buffer_remove() {
     if (count > 0) {
         unsigned char data = circular_buffer[tail]; // Get the data
-        tail = (tail + 1) % BUFFER_SIZE; // Move tail pointer
+        if (++tail == BUFFER_SIZE) tail = 0; // Move tail pointer (wrap without a division)
         count--; // Decrease the count
         return data; // Return the data
     } else {
         // Buffer underrun error
-        while (!(UCA0IFG & UCTXIFG)); // Wait for transmit buffer to be ready
-        UCA0TXBUF = 'U'; // Send error message (example: 'U' for underrun)
+        uart_write(&uart, 'U'); // Send error message (example: 'U' for underrun)
         return 0;
     }
 }
 
+// Handle one received byte (called from the UART ISR)
+void receive_byte(unsigned char RxByte) {
+    if (RxByte != 13) { // Ignore carriage return (ASCII 13)
+        circular_buffer_add(RxByte); // Add received byte to the circular buffer
+    }
+
+    if (RxByte == 13) { // Check for carriage return
+        if (count > 0) {
+            unsigned char removedByte = circular_buffer_remove(); // Remove a byte from the buffer
+            uart_write(&uart, removedByte); // Transmit the removed byte back
+        } else {
+            circular_buffer_remove(); // Empty buffer: only report the underrun, don't echo a stray 0
+        }
+    }
+}
+
 // Clock initialization (SMCLK = 1 MHz)
 void clkInit() {
     CSCTL0 = 0xA500;                  // Write password to modify CS registers
@@ -55,14 +73,8 @@ void configure_UART() {
     P2SEL0 &= ~(BIT0 | BIT1);
     P2SEL1 |= (BIT0 | BIT1);
 
-    UCA0CTLW0 |= UCSWRST;              // Put UART in reset mode
-    UCA0CTLW0 |= UCSSEL__SMCLK;        // Use SMCLK (1 MHz after division)
-
-    UCA0BRW = 104;                     // Set baud rate for 9600 (SMCLK 1 MHz)
-    UCA0MCTLW = 0xD600;                // Set modulation UCBRSx=0xD6, UCOS16=1
-
-    UCA0CTLW0 &= ~UCSWRST;             // Release UART from reset
-    UCA0IE |= UCRXIE; // Enable UART Rx interrupt
+    uart_init(&uart, &UCA0CTLW0, 104, 0xD600); // 9600 baud (SMCLK 1 MHz), UCBRSx=0xD6, UCOS16=1
+    uart.rx_handler = receive_byte;    // Handle each byte in the ISR instead of queuing it
 }
 
 
@@ -77,22 +89,18 @@ void main(void) {
     __bis_SR_register(GIE); // Enable global interrupts
 
     while (1) {
-        UCA0TXBUF = 'A'; // Continuously transmit 'A'
+        __disable_interrupt(); // Check for room with interrupts off so no wake-up is missed
+        if (uart_tx_space(&uart) > TX_RESERVE) {
+            __enable_interrupt();
+            uart_write(&uart, 'A'); // Continuously transmit 'A'
+        } else {
+            __bis_SR_register(LPM0_bits | GIE); // Sleep until the transmitter makes room
+        }
     }
 }
 
-// UART ISR to handle received data
+// UART ISR: send queued bytes and hand received ones to receive_byte
 #pragma vector = USCI_A0_VECTOR
 __interrupt void uart_ISR(void) {
-    unsigned char RxByte = UCA0RXBUF; // Read received byte
-
-    if (RxByte != 13) { // Ignore carriage return (ASCII 13)
-        circular_buffer_add(RxByte); // Add received byte to the circular buffer
-    }
-
-    if (RxByte == 13) { // Check for carriage return
-        unsigned char removedByte = circular_buffer_remove(); // Remove a byte from the buffer
-        while (!(UCA0IFG & UCTXIFG)); // Wait for transmit buffer to be ready
-        UCA0TXBUF = removedByte; // Transmit the removed byte back
-    }
+    uart_isr(&uart);
 }
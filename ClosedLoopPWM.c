@@ -0,0 +1,387 @@
+#include "msp430fr5739.h"
+
+#include "UartTransport.h"
+
+// Circular buffer parameters
+#define BUFFER_SIZE 50
+
+// Packet format: start byte, command, data byte 1, data byte 2, escape byte
+#define START_BYTE 0xFF
+#define PACKET_SIZE 5
+
+// Commands (data bytes carry a 16-bit value)
+#define CMD_SETPOINT 0x04                  // Set the duty setpoint (0 to DUTY_MAX)
+#define CMD_KP 0x05                        // Set the proportional gain (Q8)
+#define CMD_KI 0x06                        // Set the integral gain (Q8)
+#define CMD_KD 0x07                        // Set the derivative gain (Q8)
+#define CMD_MEASURED 0x08                  // Report the measured duty
+#define CMD_JITTER 0x09                    // Report control loop jitter in SMCLK ticks
+#define CMD_SETTLING 0x0A                  // Report the last step's settling time in loop periods
+
+// PWM output on TB1.1 (P3.4): 500 Hz at SMCLK 1 MHz
+#define PWM_PERIOD 2000
+
+// Control loop on Timer A0 CCR0: 100 Hz at SMCLK 1 MHz
+#define CONTROL_PERIOD 10000
+
+// Duty cycle is fixed point with DUTY_MAX = 100 %
+#define DUTY_SHIFT 10
+#define DUTY_MAX (1 << DUTY_SHIFT)
+
+#define SETTLED_BAND (DUTY_MAX / 50)       // Settled once within 2 % of the setpoint...
+#define SETTLED_LOOPS 10                   // ...for this many loop periods in a row
+#define STALE_LOOPS 3                      // No edges for this long means the duty is 0 % or 100 %
+
+// Circular buffer variables
+unsigned char circular_buffer[BUFFER_SIZE]; // Circular buffer
+volatile unsigned int head = 0;             // Head index
+volatile unsigned int tail = 0;             // Tail index
+volatile unsigned int count = 0;            // Current count of elements in the buffer
+unsigned int dropped_bytes = 0;             // Bytes discarded while resynchronizing to a start byte
+
+struct uart_port uart;                      // eUSCI_A0 on P2.0/P2.1, 9600 baud
+
+// Capture feedback (written by the capture ISR)
+volatile unsigned int measured_high = 0;    // High time of the last pulse in SMCLK ticks
+volatile unsigned int measured_period = 0;  // Last rising-to-rising period in SMCLK ticks
+volatile unsigned char new_measurement = 0; // Set on each falling edge, cleared by the control loop
+
+// Controller state (gains are Q8)
+volatile unsigned int setpoint = DUTY_MAX / 2;
+volatile int kp = 128;                      // 0.5
+volatile int ki = 64;                       // 0.25 per loop period
+volatile int kd = 0;
+long integral = 0;                          // Integral term, Q8
+unsigned int measured_duty = 0;             // Latest feedback
+unsigned int last_measured_duty = 0;        // Feedback from the previous loop period
+unsigned char stale_loops = 0;              // Loop periods without a new measurement
+
+// Loop timing and step response statistics
+unsigned int min_latency = 0xFFFF;          // Shortest delay from the timer tick to the loop
+unsigned int max_latency = 0;               // Longest delay from the timer tick to the loop
+unsigned int step_loops = 0;                // Loop periods since the last setpoint change
+unsigned int settled_loops = 0;             // Consecutive loop periods within SETTLED_BAND
+volatile unsigned int settling_time = 0;    // Loop periods the last step took to settle (0 = not yet)
+
+// Function Prototypes
+void circular_buffer_add(unsigned char data);
+unsigned char circular_buffer_remove();
+unsigned char circular_buffer_peek(unsigned int index);
+void clkInit();
+void configure_UART();
+void configure_timer_b();
+void configure_timer_a_capture();
+void configure_control_timer();
+void set_setpoint(unsigned int duty);
+void process_packets();
+void transmit_response(unsigned char command, unsigned int data);
+
+// Add data to the circular buffer
+void circular_buffer_add(unsigned char data) {
+    if (count < BUFFER_SIZE) {
+        circular_buffer[head] = data; // Add the new data
+        if (++head == BUFFER_SIZE) head = 0; // Move head pointer (wrap without a division)
+        count++; // Increase the count
+    } else {
+        // Buffer overrun error
+        uart_write(&uart, 'E'); // Send error message (example: 'E' for overrun)
+    }
+}
+
+// Remove data from the circular buffer
+unsigned char circular_buffer_remove() {
+    if (count > 0) {
+        unsigned char data = circular_buffer[tail]; // Get the data
+        if (++tail == BUFFER_SIZE) tail = 0; // Move tail pointer (wrap without a division)
+        count--; // Decrease the count
+        return data; // Return the data
+    } else {
+        return 0;  // No underrun check
+    }
+}
+
+// Peek data from the circular buffer without removing
+unsigned char circular_buffer_peek(unsigned int index) {
+    if (index < count) {
+        unsigned int pos = tail + index;
+        if (pos >= BUFFER_SIZE) pos -= BUFFER_SIZE; // index < count, so a single wrap is enough
+        return circular_buffer[pos];
+    } else {
+        return 0; // Index out of bounds
+    }
+}
+
+// Clock initialization (SMCLK = 1 MHz)
+void clkInit() {
+    CSCTL0 = 0xA500;                  // Write password to modify CS registers
+    CSCTL1 = DCOFSEL_3;               // Set DCO to 8 MHz
+    CSCTL2 = SELM__DCOCLK | SELS__DCOCLK | SELA__DCOCLK;  // Set MCLK, SMCLK, ACLK to DCO
+    CSCTL3 = DIVA__8 | DIVS__8;       // Divide SMCLK and ACLK by 8 (1 MHz)
+    CSCTL0_H = 0;                     // Lock CS registers
+}
+
+// Function to configure UART with correct baud rate and settings
+void configure_UART() {
+    // Select SMCLK for UART and configure UART pins
+    P2SEL0 &= ~(BIT0 | BIT1);
+    P2SEL1 |= (BIT0 | BIT1);
+
+    uart_init(&uart, &UCA0CTLW0, 104, 0xD600); // 9600 baud (SMCLK 1 MHz), UCBRSx=0xD6, UCOS16=1
+    uart.rx_handler = circular_buffer_add; // Parse from the circular buffer rather than the RX queue
+}
+
+// Configure Timer B to drive the plant with PWM on TB1.1
+void configure_timer_b() {
+    // Configure P3.4 for TB1.1 output (LED5)
+    P3DIR |= BIT4;            // Set P3.4 as output
+    P3SEL1 &= ~BIT4;          // Set function for Timer B output
+    P3SEL0 |= BIT4;
+
+    TB1CCR0 = PWM_PERIOD - 1; // Timer period (500 Hz)
+
+    // Latch compare updates (CLLD_1) so a new duty only takes effect when TB1R
+    // returns to 0, never part way through a period
+    TB1CCTL1 = OUTMOD_7 | CLLD_1; // Reset/set mode for TB1.1
+    TB1CCR1 = PWM_PERIOD / 2;     // Start at 50 % duty
+
+    // Start the timer in up mode
+    TB1CTL = TBSSEL_2 | MC_1 | TBCLR;  // SMCLK as clock source, up mode
+}
+
+// Configure Timer A1 to capture the plant output on TA1.1 (P1.2)
+void configure_timer_a_capture() {
+    P1DIR &= ~BIT2;         // Set P1.2 as input
+    P1SEL1 |= BIT2;         // Select TA1.1 function (capture input)
+    P1SEL0 &= ~BIT2;        // Clear P1SEL0 to set as Timer A capture
+
+    TA1CCTL1 = CM_3 | CCIS_0 | CAP | SCS | CCIE; // Capture both edges, capture mode, enable interrupt
+    TA1CTL = TASSEL_2 | MC_2 | TACLR;  // SMCLK as clock source, continuous mode, clear timer
+}
+
+// Configure Timer A0 to run the control loop every CONTROL_PERIOD ticks
+void configure_control_timer() {
+    TA0CCR0 = CONTROL_PERIOD - 1;      // Control loop period (10 ms = 100 Hz)
+    TA0CCTL0 = CCIE;                   // Enable Timer A interrupt
+    TA0CTL = TASSEL_2 | MC_1 | TACLR;  // SMCLK, up mode, clear timer
+}
+
+// Change the setpoint and start timing the step response
+void set_setpoint(unsigned int duty) {
+    if (duty > DUTY_MAX) duty = DUTY_MAX;
+
+    __disable_interrupt();            // The control loop must see all of this at once
+    setpoint = duty;
+    step_loops = 0;
+    settled_loops = 0;
+    settling_time = 0;
+    __enable_interrupt();
+}
+
+// Parse and execute the packets waiting in the circular buffer
+void process_packets() {
+    // Every pass either consumes a whole packet or discards at least one byte,
+    // so the work done is bounded by the number of bytes received
+    while (count >= PACKET_SIZE) {
+        if (circular_buffer_peek(0) != START_BYTE) {
+            // Not a start byte, discard the byte
+            circular_buffer_remove();
+            dropped_bytes++;
+            continue;
+        }
+
+        // Data bytes equal to the start byte are sent as 0 with an escape bit, so
+        // bytes 1 to 4 are never 0xFF. One that is starts a new packet: the bytes
+        // before it were a truncated packet, so drop them and resync there
+        unsigned int j;
+        for (j = 1; j < PACKET_SIZE; j++) {
+            if (circular_buffer_peek(j) == START_BYTE) break;
+        }
+        if (j < PACKET_SIZE) {
+            while (j--) {
+                circular_buffer_remove();
+                dropped_bytes++;
+            }
+            continue;
+        }
+
+        unsigned char command = circular_buffer_peek(1);
+        unsigned char escape_byte = circular_buffer_peek(4);
+
+        // Anything else means this 0xFF was noise, so drop it and resync on the next one
+        if (command < CMD_SETPOINT || command > CMD_SETTLING || (escape_byte & ~0x03)) {
+            circular_buffer_remove(); // Remove the false start byte
+            dropped_bytes++;
+            continue;
+        }
+
+        unsigned char data_byte1 = circular_buffer_peek(2);
+        unsigned char data_byte2 = circular_buffer_peek(3);
+
+        // Remove the processed packet from the buffer
+        for (j = 0; j < PACKET_SIZE; j++) {
+            circular_buffer_remove();
+        }
+
+        // Handle escape bytes
+        if (escape_byte & 0x01) {
+            data_byte1 = 0xFF;
+        }
+        if (escape_byte & 0x02) {
+            data_byte2 = 0xFF;
+        }
+
+        // Combine data bytes into a 16-bit number
+        unsigned int received_data = ((unsigned int)data_byte1 << 8) | data_byte2;
+
+        switch (command) {
+            case CMD_SETPOINT:
+                set_setpoint(received_data);
+                transmit_response(command, setpoint);
+                break;
+            case CMD_KP:
+                kp = received_data;
+                transmit_response(command, kp);
+                break;
+            case CMD_KI:
+                ki = received_data;
+                transmit_response(command, ki);
+                break;
+            case CMD_KD:
+                kd = received_data;
+                transmit_response(command, kd);
+                break;
+            case CMD_MEASURED:
+                transmit_response(command, measured_duty);
+                break;
+            case CMD_JITTER:
+                transmit_response(command, max_latency - min_latency);
+                break;
+            case CMD_SETTLING:
+                transmit_response(command, settling_time);
+                break;
+        }
+    }
+}
+
+// Transmit a response packet (start byte, command, 16-bit data, escape byte)
+void transmit_response(unsigned char command, unsigned int data) {
+    unsigned char upper_byte = (data >> 8) & 0xFF;
+    unsigned char lower_byte = data & 0xFF;
+
+    // Set escape bits for data bytes equal to the start byte and send those as 0
+    unsigned char escape_byte = 0x00;
+    if (upper_byte == 0xFF) {
+        escape_byte |= 0x01;
+        upper_byte = 0x00;
+    }
+    if (lower_byte == 0xFF) {
+        escape_byte |= 0x02;
+        lower_byte = 0x00;
+    }
+
+    // Wait for room for the whole packet (the TX interrupt drains the queue)
+    while (uart_tx_space(&uart) < PACKET_SIZE);
+
+    uart_write(&uart, START_BYTE);
+    uart_write(&uart, command);
+    uart_write(&uart, upper_byte);
+    uart_write(&uart, lower_byte);
+    uart_write(&uart, escape_byte);
+}
+
+void main(void) {
+    WDTCTL = WDTPW | WDTHOLD; // Stop watchdog timer
+
+    clkInit();
+    configure_UART();
+    configure_timer_b();          // PWM output to the plant
+    configure_timer_a_capture();  // Feedback from the plant
+    configure_control_timer();    // Fixed-rate control loop
+
+    __bis_SR_register(GIE); // Enable global interrupts
+
+    while (1) {
+        process_packets();    // Handle any complete packets in the buffer
+    }
+}
+
+// UART ISR: send queued responses and add received bytes to the circular buffer
+#pragma vector = USCI_A0_VECTOR
+__interrupt void uart_ISR(void) {
+    uart_isr(&uart);
+}
+
+// Timer A1 capture ISR: measure the high time and period of the plant output
+#pragma vector = TIMER1_A1_VECTOR
+__interrupt void Timer_A_Capture_ISR(void) {
+    static unsigned int rising_edge = 0;
+
+    switch (__even_in_range(TA1IV, TA1IV_TACCR1)) {
+        case TA1IV_TACCR1:
+            if (TA1CCTL1 & CCI) {  // Rising edge
+                measured_period = TA1CCR1 - rising_edge;
+                rising_edge = TA1CCR1;
+            } else {               // Falling edge
+                measured_high = TA1CCR1 - rising_edge;
+                new_measurement = 1;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Timer A0 ISR: one control loop iteration (PI with derivative on measurement)
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void Control_Loop_ISR(void) {
+    // TA0R restarted from 0 at the tick, so it now holds the interrupt latency
+    unsigned int latency = TA0R;
+    if (latency < min_latency) min_latency = latency;
+    if (latency > max_latency) max_latency = latency;
+
+    // Feedback: duty from the last complete pulse, or the pin level if edges stopped
+    if (new_measurement) {
+        new_measurement = 0;
+        stale_loops = 0;
+        if (measured_period != 0) {
+            unsigned long duty = ((unsigned long)measured_high << DUTY_SHIFT) / measured_period;
+            measured_duty = (duty > DUTY_MAX) ? DUTY_MAX : duty;
+        }
+    } else if (++stale_loops >= STALE_LOOPS) {
+        stale_loops = STALE_LOOPS;
+        measured_duty = (TA1CCTL1 & CCI) ? DUTY_MAX : 0; // Stuck high or low
+    }
+
+    int error = (int)setpoint - (int)measured_duty;
+    long p_term = ((long)kp * error) >> 8;
+    long d_term = -(((long)kd * ((int)measured_duty - (int)last_measured_duty)) >> 8);
+    long candidate = integral + (long)ki * error;
+    long output = p_term + (candidate >> 8) + d_term;
+    last_measured_duty = measured_duty;
+
+    // Anti-windup: only keep integrating if it doesn't push further into saturation
+    if (output > DUTY_MAX) {
+        output = DUTY_MAX;
+        if (error < 0) integral = candidate;
+    } else if (output < 0) {
+        output = 0;
+        if (error > 0) integral = candidate;
+    } else {
+        integral = candidate;
+    }
+
+    // Latched by CLLD_1, so the new duty starts with the next PWM period
+    TB1CCR1 = ((unsigned long)output * PWM_PERIOD) >> DUTY_SHIFT;
+
+    // Step response: settled once the error stays in band for SETTLED_LOOPS periods
+    if (settling_time == 0) {
+        step_loops++;
+        if (error < SETTLED_BAND && error > -SETTLED_BAND) {
+            if (++settled_loops == SETTLED_LOOPS) {
+                settling_time = step_loops - SETTLED_LOOPS + 1;
+            }
+        } else {
+            settled_loops = 0;
+        }
+    }
+}
@@ -2,6 +2,16 @@
 #include "msp430fr5739.h"
 #include "msp430fr57xxgeneric.h"
 
+#include "UartTransport.h"
+
+struct uart_port uart;                 // eUSCI_A0 on P2.0/P2.1, 9600 baud
+
+// Function Prototypes
+void clkInit();
+void configure_UART();
+void configure_LED();
+void echo_bytes();
+
 // Clock initialization (SMCLK = 1 MHz)
 void clkInit() {
     CSCTL0 = 0xA500;                  // Write password to modify CS registers
@@ -14,18 +24,11 @@ void clkInit() {
 
 // Function to configure UART with correct baud rate and settings
 void configure_UART() {
-    // Select SMCLK for UART and configure UART pins
+    // Select the UART function on P2.0/P2.1
     P2SEL0 &= ~(BIT0 | BIT1);
     P2SEL1 |= (BIT0 | BIT1);
 
-    UCA0CTLW0 |= UCSWRST;              // Put UART in reset mode
-    UCA0CTLW0 |= UCSSEL__SMCLK;        // Use SMCLK (1 MHz after division)
-
-    UCA0BRW = 104;                     // Set baud rate for 9600 (SMCLK 1 MHz)
-    UCA0MCTLW = 0xD600;                // Set modulation UCBRSx=0xD6, UCOS16=1
-
-    UCA0CTLW0 &= ~UCSWRST;             // Release UART from reset
-    UCA0IE |= UCRXIE;                  // Enable UART Rx interrupt
+    uart_init(&uart, &UCA0CTLW0, 104, 0xD600); // 9600 baud (SMCLK 1 MHz), UCBRSx=0xD6, UCOS16=1
 }
 
 void configure_LED() {
@@ -34,6 +37,24 @@ void configure_LED() {
     PJOUT &= ~BIT0;                    // Initialize LED1 as off
 }
 
+// Echo each received byte followed by the next byte in the ASCII table, and control LED1.
+// A byte is only taken once both replies fit in the TX queue, so none is ever dropped
+void echo_bytes() {
+    unsigned char RxByte;
+
+    while (uart_tx_space(&uart) >= 2 && uart_read(&uart, &RxByte)) {
+        uart_write(&uart, RxByte);     // Echo the received byte
+        uart_write(&uart, RxByte + 1); // Transmit next byte in ASCII table
+
+        // Control LED1 based on the received byte
+        if (RxByte == 'j') {
+            PJOUT |= BIT0;             // Turn on LED1 (P1.0) when 'j' is received
+        } else if (RxByte == 'k') {
+            PJOUT &= ~BIT0;            // Turn off LED1 (P1.0) when 'k' is received
+        }
+    }
+}
+
 int main(void) {
     WDTCTL = WDTPW | WDTHOLD;          // Stop watchdog timer
 
@@ -45,30 +66,19 @@ int main(void) {
     __bis_SR_register(GIE);            // Enable global interrupts
 
     while (1) {
-        __no_operation();              // Idle loop
+        echo_bytes();
+
+        __disable_interrupt();         // Check for work with interrupts off so no wake-up is missed
+        if (uart.rx_head == uart.rx_tail || uart_tx_space(&uart) < 2) {
+            __bis_SR_register(LPM0_bits | GIE); // Sleep until a byte is received or sent
+        } else {
+            __enable_interrupt();
+        }
     }
 }
 
-// UART ISR to echo received byte, send the next byte, and control LED1
+// UART ISR: queue received bytes and send queued ones, main does the echo
 #pragma vector = USCI_A0_VECTOR
 __interrupt void uart_ISR(void) {
-    if (UCA0IFG & UCRXIFG) {            // Check if RX interrupt occurred
-        unsigned char RxByte = UCA0RXBUF;   // Read received byte
-
-
-        // Wait for the transmit buffer to be ready before sending the next byte
-        while (!(UCA0IFG & UCTXIFG));   // Ensure previous byte is fully sent
-        UCA0TXBUF = RxByte;         // Transmit next byte in ASCII table
-
-        // Wait for the transmit buffer to be ready before sending the next byte
-        while (!(UCA0IFG & UCTXIFG));   // Ensure previous byte is fully sent
-        UCA0TXBUF = RxByte + 1;         // Transmit next byte in ASCII table
-
-        // Control LED1 based on the received byte
-        if (RxByte == 'j') {
-            PJOUT |= BIT0;              // Turn on LED1 (P1.0) when 'j' is received
-        } else if (RxByte == 'k') {
-            PJOUT &= ~BIT0;             // Turn off LED1 (P1.0) when 'k' is received
-        }
-    }
+    uart_isr(&uart);
 }
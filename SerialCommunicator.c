@@ -1,16 +1,75 @@
 #include "msp430fr5739.h"
 
+#include "UartTransport.h"
+
 // Circular buffer parameters
 #define BUFFER_SIZE 50
 
+// Packet format: start byte, command, data byte 1, data byte 2, escape byte
+#define START_BYTE 0xFF
+#define PACKET_SIZE 5
+
+// Clock statistics reported by command 0x04 (the data selects one, the response carries it)
+#define STAT_LAST_SWITCH 0                  // Duration of the last clock switch in us
+#define STAT_MAX_SWITCH 1                   // Longest clock switch seen in us
+#define STAT_LOST_BYTES 2                   // Frames that started while the UART was held in reset
+
+// Clock operating points (DCO and dividers). SMCLK changes with the operating
+// point, so peripherals timed from SMCLK register a handler to re-time themselves
+#define CLOCK_LOW 0                         // MCLK 1 MHz, SMCLK 1 MHz (idle)
+#define CLOCK_NOMINAL 1                     // MCLK 8 MHz, SMCLK 1 MHz (same as clkInit)
+#define CLOCK_HIGH 2                        // MCLK 24 MHz, SMCLK 3 MHz (packet bursts)
+#define CLOCK_POINTS 3
+
+#define CLOCK_PRE_CHANGE 0                  // Handler event: SMCLK is about to change
+#define CLOCK_POST_CHANGE 1                 // Handler event: SMCLK has changed
+#define CLOCK_QUERY 2                       // Handler event: return 0 to postpone the change
+#define MAX_CLOCK_HANDLERS 4
+
+#define RX_HIGH_WATER (BUFFER_SIZE / 2)     // Raise the clock once the RX queue is this full
+#define CHAR_TIME_US 1042                   // One 10-bit character at 9600 baud
+#define STOP_GAP_US 52                      // RXIFG comes mid stop bit, so back-to-back frames leave half a bit
+#define SWITCH_MARGIN_US 8                  // From the query to the start of the switch
+
+struct clock_point {
+    unsigned int dcofsel;                   // CSCTL1 value
+    unsigned int dividers;                  // CSCTL3 value
+    unsigned char smclk_mhz;                // Resulting SMCLK in MHz
+    unsigned int uart_brw;                  // UCA0BRW for 9600 baud at this SMCLK
+    unsigned int uart_mctlw;                // UCA0MCTLW for 9600 baud at this SMCLK
+};
+
+// Handlers return 1, except for CLOCK_QUERY where 0 means "not now"
+typedef unsigned char (*clock_handler)(unsigned char event, const struct clock_point *point);
+
+// FR57xx FRAM inserts its own wait states above 8 MHz, so no extra setup is needed for CLOCK_HIGH
+const struct clock_point clock_points[CLOCK_POINTS] = {
+    { DCOFSEL_3,           DIVA__8 | DIVS__8 | DIVM__8, 1, 104, 0xD600 },
+    { DCOFSEL_3,           DIVA__8 | DIVS__8 | DIVM__1, 1, 104, 0xD600 },
+    { DCORSEL | DCOFSEL_3, DIVA__8 | DIVS__8 | DIVM__1, 3, 19,  0xAA81 }, // UCOS16=1, UCBRFx=8, UCBRSx=0xAA
+};
+
 // Circular buffer variables
 unsigned char circular_buffer[BUFFER_SIZE]; // Circular buffer
 volatile unsigned int head = 0;             // Head index
 volatile unsigned int tail = 0;             // Tail index
 volatile unsigned int count = 0;            // Current count of elements in the buffer
+unsigned int dropped_bytes = 0;             // Bytes discarded while resynchronizing to a start byte
+
+struct uart_port uart;                      // eUSCI_A0 on P2.0/P2.1, 9600 baud
+
+// Clock scaling variables
+unsigned char clock_point = CLOCK_NOMINAL;          // Current operating point
+clock_handler clock_handlers[MAX_CLOCK_HANDLERS];   // Peripherals to re-time on a change
+unsigned int clock_handler_count = 0;               // Number of registered handlers
+unsigned int last_switch_us = 0;                    // Duration of the last clock switch
+unsigned int max_switch_us = 0;                     // Longest clock switch seen
+volatile unsigned int last_rx_ticks = 0;            // TA0R when the last byte was received
+unsigned int switch_lost_bytes = 0;                 // Frames that started while the UART was held in reset
 
 // Function Prototypes
 void circular_buffer_add(unsigned char data);
+void receive_byte(unsigned char data);
 unsigned char circular_buffer_remove();
 unsigned char circular_buffer_peek(unsigned int index);
 void clkInit();
@@ -18,18 +77,24 @@ void configure_UART();
 void configure_LED1();
 void control_LED1(unsigned char state);
 void configure_timer_b(unsigned int period);
-void transmit_response(unsigned int data);
+void transmit_response(unsigned char command, unsigned int data);
+void process_packets();
+void configure_switch_timer();
+void register_clock_handler(clock_handler handler);
+void set_clock_point(unsigned char point);
+void clock_policy();
+unsigned char retime_UART(unsigned char event, const struct clock_point *point);
+unsigned char retime_timer_b(unsigned char event, const struct clock_point *point);
 
 // Add data to the circular buffer
 void circular_buffer_add(unsigned char data) {
     if (count < BUFFER_SIZE) {
         circular_buffer[head] = data; // Add the new data
-        head = (head + 1) % BUFFER_SIZE; // Move head pointer
+        if (++head == BUFFER_SIZE) head = 0; // Move head pointer (wrap without a division)
         count++; // Increase the count
     } else {
         // Buffer overrun error
-        while (!(UCA0IFG & UCTXIFG)); // Wait for transmit buffer to be ready
-        UCA0TXBUF = 'E'; // Send error message (example: 'E' for overrun)
+        uart_write(&uart, 'E'); // Send error message (example: 'E' for overrun)
     }
 }
 
@@ -37,7 +102,7 @@ void circular_buffer_add(unsigned char data) {
 unsigned char circular_buffer_remove() {
     if (count > 0) {
         unsigned char data = circular_buffer[tail]; // Get the data
-        tail = (tail + 1) % BUFFER_SIZE; // Move tail pointer
+        if (++tail == BUFFER_SIZE) tail = 0; // Move tail pointer (wrap without a division)
         count--; // Decrease the count
         return data; // Return the data
     } else {
@@ -48,7 +113,8 @@ unsigned char circular_buffer_remove() {
 // Peek data from the circular buffer without removing
 unsigned char circular_buffer_peek(unsigned int index) {
     if (index < count) {
-        unsigned int pos = (tail + index) % BUFFER_SIZE;
+        unsigned int pos = tail + index;
+        if (pos >= BUFFER_SIZE) pos -= BUFFER_SIZE; // index < count, so a single wrap is enough
         return circular_buffer[pos];
     } else {
         return 0; // Index out of bounds
@@ -64,20 +130,126 @@ void clkInit() {
     CSCTL0_H = 0;                     // Lock CS registers
 }
 
+// Free-running Timer A0 on SMCLK, used to time clock switches
+void configure_switch_timer() {
+    TA0CTL = TASSEL_2 | MC_2 | TACLR;  // SMCLK, continuous mode, clear timer
+}
+
+// Register a peripheral to be re-timed whenever SMCLK changes
+void register_clock_handler(clock_handler handler) {
+    if (clock_handler_count < MAX_CLOCK_HANDLERS) {
+        clock_handlers[clock_handler_count++] = handler;
+    }
+}
+
+// Switch to another operating point and re-time every registered peripheral.
+// If a peripheral can't be re-timed right now the switch is skipped, and the
+// policy asks again on its next pass
+void set_clock_point(unsigned char point) {
+    if (point == clock_point || point >= CLOCK_POINTS) return;
+
+    const struct clock_point *old_point = &clock_points[clock_point];
+    const struct clock_point *new_point = &clock_points[point];
+    unsigned char retime = (old_point->smclk_mhz != new_point->smclk_mhz); // Re-time only if SMCLK moves
+    unsigned int start, changed, end, i;
+
+    // Interrupts stay off so no ISR ever runs with a half re-timed peripheral
+    unsigned short state = __get_interrupt_state();
+    __disable_interrupt();
+
+    if (retime) {
+        for (i = 0; i < clock_handler_count; i++) {
+            if (!clock_handlers[i](CLOCK_QUERY, new_point)) {
+                __set_interrupt_state(state);
+                return;
+            }
+        }
+    }
+
+    start = TA0R;
+    if (retime) {
+        for (i = 0; i < clock_handler_count; i++) {
+            clock_handlers[i](CLOCK_PRE_CHANGE, new_point);
+        }
+    }
+
+    changed = TA0R;
+    CSCTL0 = 0xA500;                  // Write password to modify CS registers
+    CSCTL1 = new_point->dcofsel;      // Select the DCO frequency
+    CSCTL3 = new_point->dividers;     // Select the MCLK, SMCLK and ACLK dividers
+    CSCTL0_H = 0;                     // Lock CS registers
+    clock_point = point;
+
+    if (retime) {
+        for (i = 0; i < clock_handler_count; i++) {
+            clock_handlers[i](CLOCK_POST_CHANGE, new_point);
+        }
+    }
+    end = TA0R;
+
+    // TA0 counts SMCLK, so convert each side of the switch with its own clock
+    last_switch_us = (changed - start) / old_point->smclk_mhz + (end - changed) / new_point->smclk_mhz;
+    if (last_switch_us > max_switch_us) max_switch_us = last_switch_us;
+
+    __set_interrupt_state(state);
+}
+
+// Policy hook: run fast while the RX queue backs up, drop to idle once it has drained.
+// Either switch waits for a gap between frames (see retime_UART)
+void clock_policy() {
+    if (count >= RX_HIGH_WATER) {
+        set_clock_point(CLOCK_HIGH);
+    } else if (count == 0) {
+        set_clock_point(CLOCK_LOW);
+    }
+}
+
+// Re-time the UART baud rate generator around a clock change. The UART is held
+// in reset during the change, so it only happens in a gap between frames
+unsigned char retime_UART(unsigned char event, const struct clock_point *point) {
+    if (event == CLOCK_QUERY) {
+        // Not while a byte is on the wire or waiting for the ISR (UCBUSY drops once
+        // the stop bit has been sampled). Queued responses simply wait in the TX
+        // queue until the UART is released
+        if ((UCA0STATW & UCBUSY) || (UCA0IFG & UCRXIFG)) return 0;
+
+        // Then either the line has been quiet for a character time, or the byte
+        // just received is still in its stop bit and the switch (the longest seen
+        // so far) ends before the next start bit can arrive. Sustained traffic
+        // never leaves a quiet character, so only the second lets the clock rise
+        // under load. TA0 wrapping during a long gap can only make the gap look
+        // shorter, which just waits longer
+        unsigned int elapsed_us = (unsigned int)(TA0R - last_rx_ticks) / clock_points[clock_point].smclk_mhz;
+        return elapsed_us >= CHAR_TIME_US || elapsed_us + max_switch_us + SWITCH_MARGIN_US <= STOP_GAP_US;
+    } else if (event == CLOCK_PRE_CHANGE) {
+        uart_suspend(&uart);               // Hold UART in reset while SMCLK changes
+    } else {
+        // RX (P2.1) low means a start bit arrived during the switch: that byte is
+        // lost, or misframed from a later falling edge
+        if (!(P2IN & BIT1)) switch_lost_bytes++;
+
+        uart_resume(&uart, point->uart_brw, point->uart_mctlw); // 9600 baud at the new SMCLK
+    }
+    return 1;
+}
+
+// Re-time Timer B so it keeps counting at 1 MHz and the PWM period and compares stay valid
+unsigned char retime_timer_b(unsigned char event, const struct clock_point *point) {
+    if (event == CLOCK_POST_CHANGE) {
+        TB1EX0 = point->smclk_mhz - 1;     // Divide SMCLK back down to 1 MHz (TBIDEX = divider - 1)
+        TB1CTL |= TBCLR;                   // Restart the divider with the new setting
+    }
+    return 1;
+}
+
 // Function to configure UART with correct baud rate and settings
 void configure_UART() {
     // Select SMCLK for UART and configure UART pins
     P2SEL0 &= ~(BIT0 | BIT1);
     P2SEL1 |= (BIT0 | BIT1);
 
-    UCA0CTLW0 |= UCSWRST;              // Put UART in reset mode
-    UCA0CTLW0 |= UCSSEL__SMCLK;        // Use SMCLK (1 MHz after division)
-
-    UCA0BRW = 104;                     // Set baud rate for 9600 (SMCLK 1 MHz)
-    UCA0MCTLW = 0xD600;                // Set modulation UCBRSx=0xD6, UCOS16=1
-
-    UCA0CTLW0 &= ~UCSWRST;             // Release UART from reset
-    UCA0IE |= UCRXIE;                  // Enable UART Rx interrupt
+    uart_init(&uart, &UCA0CTLW0, 104, 0xD600); // 9600 baud (SMCLK 1 MHz), UCBRSx=0xD6, UCOS16=1
+    uart.rx_handler = receive_byte;    // Parse from the circular buffer rather than the RX queue
 }
 
 // Function to configure LED1 (PJ.0)
@@ -128,100 +300,133 @@ void main(void) {
     clkInit();
     configure_UART();
     configure_LED1();         // Set up LED1 (PJ.0)
+    configure_switch_timer(); // Time clock switches with Timer A0
+
+    register_clock_handler(retime_UART);
+    register_clock_handler(retime_timer_b);
 
     __bis_SR_register(GIE); // Enable global interrupts
 
     while (1) {
-        // Check if a complete packet (5 bytes) is available
-        if (count >= 5) {
-            // Look for the start byte (0xFF)
-            unsigned int i;
-            for (i = 0; i <= (count - 5); i++) {
-                if (circular_buffer_peek(i) == 0xFF) {
-                    // Potential start of packet found
-                    unsigned char command = circular_buffer_peek(i + 1);
-                    unsigned char data_byte1 = circular_buffer_peek(i + 2);
-                    unsigned char data_byte2 = circular_buffer_peek(i + 3);
-                    unsigned char escape_byte = circular_buffer_peek(i + 4);
-
-                    // Handle LED control commands (0x02 = turn on LED1, 0x03 = turn off LED1)
-                    if (command == 0x02) {
-                        control_LED1(1);  // Turn on LED1
-                    } else if (command == 0x03) {
-                        control_LED1(0);  // Turn off LED1
-                    }
-
-                    // Validate command byte for timer (0x01)
-                    if (command == 0x01) {
-                        // Handle escape bytes
-                        if (escape_byte & 0x01) {
-                            data_byte1 = 0xFF;
-                        }
-                        if (escape_byte & 0x02) {
-                            data_byte2 = 0xFF;
-                        }
-
-                        // Combine data bytes into a 16-bit number
-                        unsigned int received_data = ((unsigned int)data_byte1 << 8) | data_byte2;
-
-                        // Remove processed bytes from the buffer
-                        unsigned int j;
-                        for (j = 0; j < (i + 5); j++) {
-                            circular_buffer_remove();
-                        }
-
-                        // Transmit the response and configure Timer B
-                        transmit_response(received_data);
-                        configure_timer_b(received_data);
-
-                        // Break out of the loop to process next packet
-                        break;
-                    } else {
-                        // Invalid command byte, discard the start byte
-                        circular_buffer_remove(); // Remove the start byte
-                    }
-                } else {
-                    // Not a start byte, discard the byte
-                    circular_buffer_remove();
-                }
-            }
-        }
+        clock_policy();       // Pick the operating point from the RX queue depth
+        process_packets();    // Handle any complete packets in the buffer
     }
 }
 
-// UART ISR to handle received data
+// Handle one received byte (called from the UART ISR)
+void receive_byte(unsigned char data) {
+    last_rx_ticks = TA0R;             // The clock policy waits for a quiet line after this
+    circular_buffer_add(data);        // Add received byte to the circular buffer
+}
+
+// UART ISR: send queued responses and hand received bytes to receive_byte
 #pragma vector = USCI_A0_VECTOR
 __interrupt void uart_ISR(void) {
-    unsigned char RxByte = UCA0RXBUF; // Read received byte
-    circular_buffer_add(RxByte);      // Add received byte to the circular buffer
+    uart_isr(&uart);
 }
 
-// Function to transmit a response (for testing purposes)
-void transmit_response(unsigned int data) {
-    // Example: Echo back the received 16-bit data
-    unsigned char upper_byte = (data >> 8) & 0xFF;
-    unsigned char lower_byte = data & 0xFF;
+// Parse and execute the packets waiting in the circular buffer
+void process_packets() {
+    // Every pass either consumes a whole packet or discards at least one byte,
+    // so the work done is bounded by the number of bytes received
+    while (count >= PACKET_SIZE) {
+        if (circular_buffer_peek(0) != START_BYTE) {
+            // Not a start byte, discard the byte
+            circular_buffer_remove();
+            dropped_bytes++;
+            continue;
+        }
 
-    // Transmit start byte
-    while (!(UCA0IFG & UCTXIFG));
-    UCA0TXBUF = 0xFF;
+        // Data bytes equal to the start byte are sent as 0 with an escape bit, so
+        // bytes 1 to 4 are never 0xFF. One that is starts a new packet: the bytes
+        // before it were a truncated packet, so drop them and resync there
+        unsigned int j;
+        for (j = 1; j < PACKET_SIZE; j++) {
+            if (circular_buffer_peek(j) == START_BYTE) break;
+        }
+        if (j < PACKET_SIZE) {
+            while (j--) {
+                circular_buffer_remove();
+                dropped_bytes++;
+            }
+            continue;
+        }
 
-    // Transmit command byte (e.g., 0x02 for response)
-    while (!(UCA0IFG & UCTXIFG));
-    UCA0TXBUF = 0x02;
+        unsigned char command = circular_buffer_peek(1);
+        unsigned char escape_byte = circular_buffer_peek(4);
 
-    // Transmit data bytes
-    while (!(UCA0IFG & UCTXIFG));
-    UCA0TXBUF = upper_byte;
+        // Only commands 0x01 to 0x04 exist and only escape bits 0 and 1 are used.
+        // Anything else means this 0xFF was noise, so drop it and resync on the next one
+        if (command < 0x01 || command > 0x04 || (escape_byte & ~0x03)) {
+            circular_buffer_remove(); // Remove the false start byte
+            dropped_bytes++;
+            continue;
+        }
 
-    while (!(UCA0IFG & UCTXIFG));
-    UCA0TXBUF = lower_byte;
+        unsigned char data_byte1 = circular_buffer_peek(2);
+        unsigned char data_byte2 = circular_buffer_peek(3);
 
-    // Transmit escape byte (set bits if any data byte is 0xFF)
+        // Remove the processed packet from the buffer
+        for (j = 0; j < PACKET_SIZE; j++) {
+            circular_buffer_remove();
+        }
+
+        // Handle LED control commands (0x02 = turn on LED1, 0x03 = turn off LED1)
+        if (command == 0x02) {
+            control_LED1(1);  // Turn on LED1
+        } else if (command == 0x03) {
+            control_LED1(0);  // Turn off LED1
+        } else if (command == 0x04) {
+            // Clock statistics (0x04): answer with the one the low data byte selects
+            if (data_byte2 == STAT_LAST_SWITCH) {
+                transmit_response(0x04, last_switch_us);
+            } else if (data_byte2 == STAT_MAX_SWITCH) {
+                transmit_response(0x04, max_switch_us);
+            } else if (data_byte2 == STAT_LOST_BYTES) {
+                transmit_response(0x04, switch_lost_bytes);
+            }
+        } else {
+            // Timer command (0x01): handle escape bytes
+            if (escape_byte & 0x01) {
+                data_byte1 = 0xFF;
+            }
+            if (escape_byte & 0x02) {
+                data_byte2 = 0xFF;
+            }
+
+            // Combine data bytes into a 16-bit number
+            unsigned int received_data = ((unsigned int)data_byte1 << 8) | data_byte2;
+
+            // Transmit the response and configure Timer B
+            transmit_response(0x02, received_data);
+            configure_timer_b(received_data);
+        }
+    }
+}
+
+// Function to transmit a response (command 0x02 for the timer, 0x04 for a clock statistic)
+void transmit_response(unsigned char command, unsigned int data) {
+    // Split the 16-bit data into bytes
+    unsigned char upper_byte = (data >> 8) & 0xFF;
+    unsigned char lower_byte = data & 0xFF;
+
+    // Set escape bits for data bytes equal to the start byte and send those as 0
     unsigned char escape_byte = 0x00;
-    if (upper_byte == 0xFF) escape_byte |= 0x01;
-    if (lower_byte == 0xFF) escape_byte |= 0x02;
+    if (upper_byte == 0xFF) {
+        escape_byte |= 0x01;
+        upper_byte = 0x00;
+    }
+    if (lower_byte == 0xFF) {
+        escape_byte |= 0x02;
+        lower_byte = 0x00;
+    }
+
+    // Wait for room for the whole packet (the TX interrupt drains the queue)
+    while (uart_tx_space(&uart) < PACKET_SIZE);
 
-    while (!(UCA0IFG & UCTXIFG));
-    UCA0TXBUF = escape_byte;
+    uart_write(&uart, START_BYTE);    // Start byte
+    uart_write(&uart, command);       // Command byte
+    uart_write(&uart, upper_byte);    // Data bytes
+    uart_write(&uart, lower_byte);
+    uart_write(&uart, escape_byte);   // Escape byte
 }
@@ -8,19 +8,34 @@
 #define ADC_Y_CHANNEL ADC10INCH_13
 #define ADC_Z_CHANNEL ADC10INCH_14
 
+// Sampling period per axis in SMCLK ticks (40000 = 40 ms = 25 Hz at 1 MHz).
+// Timer_A0 output TA0.1 starts each conversion in hardware. The ADC ISR switches
+// to the next axis between conversions, so the period must also cover that ISR
+#define SAMPLE_PERIOD 40000
+#define TRIGGERS_PER_SAMPLE 3          // X, Y and Z conversions per sample
+
 unsigned int adc_value;  // Store raw 10-bit ADC result
-unsigned char x_axis, y_axis, z_axis;  // Store 8-bit ADC results
+unsigned char x_axis, y_axis;          // X and Y results until Z completes the sample
 unsigned char current_axis = 0;        // Track which axis is currently being sampled
-volatile unsigned char transmit = 0;   // Flag to trigger data transmission
+
+// One timestamped accelerometer sample (time of the Z conversion)
+struct sample {
+    unsigned long timestamp;           // SMCLK ticks since start-up
+    unsigned char x_axis;              // 8-bit X-axis result
+    unsigned char y_axis;              // 8-bit Y-axis result
+    unsigned char z_axis;              // 8-bit Z-axis result
+    unsigned char rate_shift;          // Sample rate when it was taken
+};
+
+#include "AdcSampling.h"            // Trigger, sample FIFO and status packets
 
 // Function Prototypes
 void configure_UART();
 void configure_ADC10();
-void configure_timer_interrupt();
 void configure_p2_7();
-void transmit_data();
+void transmit_data(const struct sample *record);
+void fifo_push(unsigned char z_axis);
 void clkInit();
-unsigned char sampleADC(unsigned int channel);
 
 // Function to configure UART with correct baud rate and settings
 void configure_UART() {
@@ -41,15 +56,23 @@ void configure_UART() {
 void configure_ADC10() {
     // Enable ADC10, set sample and hold time to 16 ADC10CLK cycles, and turn ADC on
     ADC10CTL0 = ADC10SHT_2 | ADC10ON;  // Sample and hold time = 16 ADC10CLK cycles, ADC on
-    ADC10CTL1 = ADC10SHP | ADC10SSEL_3; // Use sampling timer, SMCLK source
+    ADC10CTL1 = ADC10_TRIGGER | ADC10SHP | ADC10SSEL_3; // Trigger on TA0.1 (or ADC10SC), sampling timer, SMCLK
     ADC10CTL2 = ADC10RES;              // 10-bit resolution
+    ADC10MCTL0 = ADC_X_CHANNEL;        // Start with the X-axis
+    ADC10IE = ADC10IE0;                // Interrupt when a conversion result is ready
+    ADC10CTL0 |= ADC10ENC;             // Enable conversions, the timer starts each one
 }
 
-// Function to configure Timer A for periodic interrupts (every 40 ms, 25 Hz)
-void configure_timer_interrupt() {
-    TA0CCR0 = 40000 - 1;               // Timer period for 40 ms (SMCLK 1 MHz / 25Hz)
-    TA0CCTL0 = CCIE;                   // Enable Timer A interrupt
-    TA0CTL = TASSEL_2 | MC_1 | TACLR;  // SMCLK, up mode, clear timer
+// Push a sample record (called from the ADC ISR only)
+void fifo_push(unsigned char z_axis) {
+    struct sample *record = fifo_claim();
+
+    if (record) {
+        record->x_axis = x_axis;
+        record->y_axis = y_axis;
+        record->z_axis = z_axis;
+        fifo_publish(record);
+    }
 }
 
 // Function to power accelerometer via P2.7
@@ -59,44 +82,44 @@ void configure_p2_7() {
 }
 
 // Function to transmit data via UART (start byte, X, Y, Z)
-void transmit_data() {
+void transmit_data(const struct sample *record) {
     transmitChar(START_BYTE);           // Transmit start byte (255)
-    transmitChar(x_axis);               // Transmit X-axis data
-    transmitChar(y_axis);               // Transmit Y-axis data
-    transmitChar(z_axis);               // Transmit Z-axis data
-}
-
-// Helper function to transmit a character via UART
-void transmitChar(unsigned char data) {
-    while (!(UCA0IFG & UCTXIFG));       // Wait for transmit buffer to be ready
-    UCA0TXBUF = data;                   // Transmit character
-}
-
-// Function to sample ADC for given channel (X, Y, or Z)
-unsigned char sampleADC(unsigned int channel) {
-    ADC10CTL0 &= ~ADC10ENC;            // Disable ADC before changing channels
-    ADC10MCTL0 = channel;              // Select the channel (X, Y, or Z axis)
-    ADC10CTL0 |= ADC10ENC | ADC10SC;   // Enable and start conversion
-    while (ADC10CTL1 & ADC10BUSY);     // Wait until conversion completes
-    return ADC10MEM0 >> 2;             // Return 8-bit result (shifted 10-bit)
+    transmitChar(record->x_axis < DATA_MAX ? record->x_axis : DATA_MAX); // Transmit X-axis data
+    transmitChar(record->y_axis < DATA_MAX ? record->y_axis : DATA_MAX); // Transmit Y-axis data
+    transmitChar(record->z_axis < DATA_MAX ? record->z_axis : DATA_MAX); // Transmit Z-axis data
 }
 
-// Timer A0 ISR (triggered every 40 ms)
-#pragma vector = TIMER0_A0_VECTOR
-__interrupt void Timer_A_ISR(void) {
-    switch (current_axis) {
-        case 0:  // Sample X-axis (A12)
-            x_axis = sampleADC(ADC_X_CHANNEL);  // Sample and store X-axis
-            current_axis = 1;                   // Move to Y-axis next
-            break;
-        case 1:  // Sample Y-axis (A13)
-            y_axis = sampleADC(ADC_Y_CHANNEL);  // Sample and store Y-axis
-            current_axis = 2;                   // Move to Z-axis next
+// ADC10 ISR (triggered when a timer-started conversion completes)
+#pragma vector = ADC10_VECTOR
+__interrupt void ADC10_ISR(void) {
+    switch (__even_in_range(ADC10IV, ADC10IV_ADC10IFG)) {
+        case ADC10IV_ADC10IFG:
+        {
+            record_latency();                   // Time since the trigger at CCR0
+            ADC10CTL0 &= ~ADC10ENC;             // Disable ADC before changing channels
+            switch (current_axis) {
+                case 0:  // X-axis (A12) finished
+                    x_axis = ADC10MEM0 >> 2;            // Store 8-bit X-axis (shifted 10-bit)
+                    ADC10MCTL0 = ADC_Y_CHANNEL;         // Sample Y-axis on the next trigger
+                    current_axis = 1;
+                    break;
+                case 1:  // Y-axis (A13) finished
+                    y_axis = ADC10MEM0 >> 2;            // Store 8-bit Y-axis
+                    ADC10MCTL0 = ADC_Z_CHANNEL;         // Sample Z-axis on the next trigger
+                    current_axis = 2;
+                    break;
+                case 2:  // Z-axis (A14) finished
+                    fifo_push(ADC10MEM0 >> 2);          // Queue X, Y and the 8-bit Z-axis for main
+                    ADC10MCTL0 = ADC_X_CHANNEL;         // Move back to X-axis
+                    current_axis = 0;
+                    __bic_SR_register_on_exit(LPM0_bits); // Wake main to send the results
+                    break;
+            }
+            sample_time += next_trigger_ticks();        // Time of the next trigger
+            ADC10CTL0 |= ADC10ENC;              // Re-arm for the next trigger
+        }
             break;
-        case 2:  // Sample Z-axis (A14)
-            z_axis = sampleADC(ADC_Z_CHANNEL);  // Sample and store Z-axis
-            current_axis = 0;                   // Move back to X-axis
-            transmit = 1;                       // Set transmit flag
+        default:
             break;
     }
 }
@@ -117,14 +140,18 @@ int main(void) {
     configure_p2_7();                 // Power accelerometer using P2.7
     configure_ADC10();                // Set up ADC for accelerometer
     configure_UART();                 // Set up UART for 9600 baud
-    configure_timer_interrupt();      // Set up Timer A interrupt
+    configure_timer_trigger();        // Set up Timer A to trigger the ADC
 
     __bis_SR_register(GIE);           // Enable global interrupts
 
     while (1) {
-        if (transmit == 1) {          // Check if transmit flag is set
-            transmit_data();          // Transmit data via UART
-            transmit = 0;             // Clear transmit flag
+        __disable_interrupt();        // Check the FIFO with interrupts off so no wake-up is missed
+        if (fifo_head == fifo_tail) {
+            __bis_SR_register(LPM0_bits | GIE); // Sleep until the ADC ISR has all three axes
+        } else {
+            __enable_interrupt();
         }
+
+        drain_samples();              // Transmit all queued samples via UART
     }
 }
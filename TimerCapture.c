@@ -1,5 +1,55 @@
 #include "msp430fr5739.h"
 
+#include "UartTransport.h"
+
+// Trace ring parameters (power of two so indexes wrap with a mask)
+#define TRACE_SIZE 64                      // 64 events x 4 bytes = 256 bytes of RAM
+#define TRACE_MASK (TRACE_SIZE - 1)
+#define TRACE_TICK_SHIFT 4                 // Timestamp deltas count 16 SMCLK ticks each
+
+// Trace event IDs
+#define TRACE_CAPTURE_ENTER 1              // Capture ISR entry, arg = TA1CCTL1
+#define TRACE_CAPTURE_EXIT 2               // Capture ISR exit, arg = trace ring depth
+#define TRACE_PULSE_WIDTH 3                // Falling edge, arg = pulse width in SMCLK ticks
+#define TRACE_DROPPED 4                    // arg = events lost since the last one because the ring was full
+#define TRACE_COST 5                       // arg = SMCLK ticks taken by 8 trace() calls
+
+// The link carries 1920 packets/s at 115200 baud. Pulse widths alone are 500
+// events/s at the 500 Hz PWM; ISR entry and exit on every edge add 2000 more,
+// which is more than the link can drain, so they are off by default
+#define TRACE_ISR_EVENTS 0                 // 1 = also trace capture ISR entry and exit
+
+// UART at 115200 baud from SMCLK 1 MHz (UCOS16 = 0, UCBRx = 8, UCBRSx = 0xD6)
+#define TRACE_UART_BRW 8
+#define TRACE_UART_MCTLW 0xD600
+
+// Trace packet on the UART: START_BYTE, id, delta, arg high, arg low, escape.
+// A 0xFF inside the packet is sent as 0x00 with its bit set in the escape byte
+// (bit 0 = delta, bit 1 = arg high, bit 2 = arg low), so 0xFF only ever marks a start
+#define START_BYTE 0xFF
+#define TRACE_PACKET_SIZE 6
+
+// One 4-byte trace event
+struct trace_event {
+    unsigned char id;                      // Event ID
+    unsigned char delta;                   // Time since the previous event (255 = at least 255)
+    unsigned int arg;                      // Event argument
+};
+
+// Trace ring variables
+struct trace_event trace_ring[TRACE_SIZE];
+volatile unsigned char trace_head = 0;     // Next event to write
+volatile unsigned char trace_tail = 0;     // Next event to send, only advanced by main
+unsigned int trace_last = 0;               // TA1R at the previous event
+unsigned int trace_dropped = 0;            // Events lost because the ring was full
+
+struct uart_port uart;                     // eUSCI_A0 on P2.0/P2.1, 115200 baud
+
+// Function Prototypes
+void trace(unsigned char id, unsigned int arg);
+void trace_drain();
+void configure_UART();
+
 void configure_timer_b() {
     // Configure P3.4 for TB1.1 output (LED5)
     P3DIR |= BIT4;            // Set P3.4 as output
@@ -59,22 +109,112 @@ void configure_timer_a_capture() {
     TA1CTL = TASSEL_2 | MC_2 | TACLR;  // SMCLK as clock source, continuous mode, clear timer
 }
 
+// Function to configure UART for trace output
+void configure_UART() {
+    // Select SMCLK for UART and configure UART pins
+    P2SEL0 &= ~(BIT0 | BIT1);
+    P2SEL1 |= (BIT0 | BIT1);
+
+    // SMCLK reset divider of 8 is left alone, so 1 MHz
+    uart_init(&uart, &UCA0CTLW0, TRACE_UART_BRW, TRACE_UART_MCTLW); // 115200 baud, UCBRSx=0xD6, UCOS16=0
+}
+
+// Record a trace event. Safe from main and ISRs: interrupts are only held off
+// for the few instructions that claim and fill the slot, so it never waits
+void trace(unsigned char id, unsigned int arg) {
+    unsigned short state = __get_interrupt_state();
+    __disable_interrupt();
+
+    if ((unsigned char)(trace_head - trace_tail) >= TRACE_SIZE) {
+        trace_dropped++;                       // Ring full: count the lost event
+    } else {
+        struct trace_event *event = &trace_ring[trace_head & TRACE_MASK];
+        unsigned int now = TA1R;               // Timer A1 runs free on SMCLK
+        unsigned int delta = (now - trace_last) >> TRACE_TICK_SHIFT;
+
+        if (delta > 255) {
+            delta = 255;                       // Saturate long gaps
+            trace_last = now;
+        } else {
+            trace_last += delta << TRACE_TICK_SHIFT; // Keep the remainder for the next delta
+        }
+
+        event->id = id;
+        event->delta = delta;
+        event->arg = arg;
+        trace_head++;                          // Publish the event
+    }
+
+    __set_interrupt_state(state);
+}
+
+// Move whole trace packets into the UART TX queue while there is room (never blocks)
+void trace_drain() {
+    while (uart_tx_space(&uart) >= TRACE_PACKET_SIZE) {
+        __disable_interrupt();                 // An ISR must not take the free slot or bump the count meanwhile
+        if (trace_dropped > 0 && (unsigned char)(trace_head - trace_tail) < TRACE_SIZE) {
+            unsigned int dropped = trace_dropped;
+            trace_dropped = 0;
+            trace(TRACE_DROPPED, dropped);     // Report the gap in the timeline
+        }
+        __enable_interrupt();
+        if (trace_head == trace_tail) return;  // Nothing to send
+
+        struct trace_event *event = &trace_ring[trace_tail & TRACE_MASK];
+        unsigned char packet[TRACE_PACKET_SIZE];
+        unsigned char escape_byte = 0x00;
+        unsigned char i;
+
+        packet[0] = START_BYTE;
+        packet[1] = event->id;
+        packet[2] = event->delta;
+        packet[3] = event->arg >> 8;
+        packet[4] = event->arg & 0xFF;
+        trace_tail++;                          // Slot is copied, free it
+
+        for (i = 0; i < 3; i++) {
+            if (packet[2 + i] == 0xFF) {
+                packet[2 + i] = 0x00;          // Escape data bytes that look like a start byte
+                escape_byte |= 1 << i;
+            }
+        }
+        packet[5] = escape_byte;
+
+        for (i = 0; i < TRACE_PACKET_SIZE; i++) {
+            uart_write(&uart, packet[i]);      // Room was checked above, so none is lost
+        }
+    }
+}
+
+// UART ISR: send the queued trace packets
+#pragma vector = USCI_A0_VECTOR
+__interrupt void uart_ISR(void) {
+    uart_isr(&uart);
+}
+
 // Timer A interrupt service routine to handle capture events
 #pragma vector = TIMER1_A1_VECTOR
 __interrupt void Timer_A_Capture_ISR(void) {
     static unsigned int rising_edge = 0, falling_edge = 0, pulse_width = 0;
 
+#if TRACE_ISR_EVENTS
+    trace(TRACE_CAPTURE_ENTER, TA1CCTL1);
+#endif
+
     if (TA1CCTL1 & CCI) {  // Check if it's a rising edge
         rising_edge = TA1CCR1;  // Capture rising edge time
     } else {  // Falling edge
         falling_edge = TA1CCR1;  // Capture falling edge time
         pulse_width = falling_edge - rising_edge;  // Calculate pulse width (in clock cycles)
 
-        // Breakpoint here to check the value of pulse_width in the debugger
-        __no_operation();  // Placeholder for debugger to check pulse_width
+        trace(TRACE_PULSE_WIDTH, pulse_width);     // Stream the pulse width instead of breaking in the debugger
     }
 
     TA1CCTL1 &= ~CCIFG;  // Clear capture interrupt flag
+
+#if TRACE_ISR_EVENTS
+    trace(TRACE_CAPTURE_EXIT, (unsigned char)(trace_head - trace_tail));
+#endif
 }
 
 int main(void) {
@@ -83,10 +223,19 @@ int main(void) {
     configure_clocks();         // Configure SMCLK to 8 MHz
     configure_timer_b();        // Configure Timer B to produce PWM
     configure_timer_a_capture(); // Configure Timer A for pulse capture
+    configure_UART();           // Configure UART for trace output
+
+    // Measure the cost of trace() itself and put it at the start of the trace
+    unsigned int start = TA1R;
+    unsigned char i;
+    for (i = 0; i < 8; i++) {
+        trace(TRACE_COST, 0);
+    }
+    trace(TRACE_COST, TA1R - start);
 
     __bis_SR_register(GIE);     // Enable global interrupts
 
     while (1) {
-        __no_operation();       // Main loop, do nothing
+        trace_drain();          // Stream trace events to the host
     }
 }
@@ -0,0 +1,152 @@
+#include "msp430fr5739.h"
+
+#include "UartTransport.h"
+
+// Ports
+#define COMMAND_PORT 0                     // eUSCI_A0 on P2.0/P2.1, 9600 baud
+#define TELEMETRY_PORT 1                   // eUSCI_A1 on P2.5/P2.6, 115200 baud
+#define UART_PORTS 2
+
+#define START_BYTE 0xFF
+#define REPORT_THROUGHPUT 0xF0             // 0xF0 + port: TX bytes/s, RX bytes/s
+
+// 1 = keep both TX queues full to measure throughput with both ports saturated
+#define BENCHMARK 1
+
+struct uart_port uart_ports[UART_PORTS];
+volatile unsigned char second_elapsed = 0; // Set by the one second tick
+
+// Function Prototypes
+void clkInit();
+void configure_LED1();
+void configure_tick_timer();
+void report_throughput(struct uart_port *out, unsigned char index);
+
+// Clock initialization (SMCLK = 1 MHz)
+void clkInit() {
+    CSCTL0 = 0xA500;                  // Write password to modify CS registers
+    CSCTL1 = DCOFSEL_3;               // Set DCO to 8 MHz
+    CSCTL2 = SELM__DCOCLK | SELS__DCOCLK | SELA__DCOCLK;  // Set MCLK, SMCLK, ACLK to DCO
+    CSCTL3 = DIVA__8 | DIVS__8;       // Divide SMCLK and ACLK by 8 (1 MHz)
+    CSCTL0_H = 0;                     // Lock CS registers
+}
+
+// Function to configure LED1 (PJ.0)
+void configure_LED1() {
+    PJDIR |= BIT0;                     // Set PJ.0 as output for LED1
+    PJOUT &= ~BIT0;                    // Initialize LED1 as off
+}
+
+// Timer A0 interrupts once a second (SMCLK / 8 / 8 = 15625 Hz)
+void configure_tick_timer() {
+    TA0CCR0 = 15625 - 1;               // One second
+    TA0CCTL0 = CCIE;                   // Enable Timer A interrupt
+    TA0EX0 = TAIDEX_7;                 // Extra divide by 8
+    TA0CTL = TASSEL_2 | ID__8 | MC_1 | TACLR; // SMCLK / 8, up mode, clear timer
+}
+
+// Queue a throughput report (start byte, 0xF0 + port, TX bytes/s, RX bytes/s)
+void report_throughput(struct uart_port *out, unsigned char index) {
+    struct uart_stats *stats = &uart_ports[index].stats;
+    uart_write(out, START_BYTE);
+    uart_write(out, REPORT_THROUGHPUT + index);
+    uart_write(out, stats->tx_rate >> 8);
+    uart_write(out, stats->tx_rate & 0xFF);
+    uart_write(out, stats->rx_rate >> 8);
+    uart_write(out, stats->rx_rate & 0xFF);
+}
+
+int main(void) {
+    WDTCTL = WDTPW | WDTHOLD;          // Stop watchdog timer
+
+    clkInit();
+    configure_LED1();
+    configure_tick_timer();
+
+    // Select the UART function on P2.0/P2.1 (eUSCI_A0) and P2.5/P2.6 (eUSCI_A1)
+    P2SEL0 &= ~(BIT0 | BIT1 | BIT5 | BIT6);
+    P2SEL1 |= (BIT0 | BIT1 | BIT5 | BIT6);
+
+    uart_init(&uart_ports[COMMAND_PORT], &UCA0CTLW0, 104, 0xD600);  // 9600 baud (SMCLK 1 MHz)
+    uart_init(&uart_ports[TELEMETRY_PORT], &UCA1CTLW0, 8, 0xD600);  // 115200 baud (SMCLK 1 MHz)
+
+    __bis_SR_register(GIE);            // Enable global interrupts
+
+    unsigned char pattern = 0;         // Benchmark fill byte (never the start byte)
+    unsigned char report_pending = 0;  // Throughput report waiting for TX queue space
+    unsigned char i;
+
+    while (1) {
+        struct uart_port *command = &uart_ports[COMMAND_PORT];
+        struct uart_port *telemetry = &uart_ports[TELEMETRY_PORT];
+        unsigned char data;
+
+        // Commands: echo each byte and control LED1 as in EnableUART.c
+        while (uart_read(command, &data)) {
+            uart_write(command, data);
+            if (data == 'j') {
+                PJOUT |= BIT0;         // Turn on LED1 when 'j' is received
+            } else if (data == 'k') {
+                PJOUT &= ~BIT0;        // Turn off LED1 when 'k' is received
+            }
+        }
+
+        // Once a second, report both ports' throughput on the telemetry port
+        if (second_elapsed) {
+            second_elapsed = 0;
+            report_pending = 1;
+        }
+        if (report_pending && uart_tx_space(telemetry) >= UART_PORTS * 6) {
+            for (i = 0; i < UART_PORTS; i++) {
+                report_throughput(telemetry, i);
+            }
+            report_pending = 0;
+        }
+
+#if BENCHMARK
+        // Keep both TX queues topped up so both ports run flat out. The telemetry
+        // queue is left to drain while a report waits for room
+        for (i = 0; i < UART_PORTS; i++) {
+            if (i == TELEMETRY_PORT && report_pending) continue;
+            while (uart_write(&uart_ports[i], pattern)) {
+                if (++pattern == START_BYTE) pattern = 0;
+            }
+        }
+#endif
+
+        __disable_interrupt();         // Check for work with interrupts off so no wake-up is missed
+        if (command->rx_head == command->rx_tail && !second_elapsed) {
+            __bis_SR_register(LPM0_bits | GIE); // Sleep until a byte moves or the tick fires
+        } else {
+            __enable_interrupt();
+        }
+    }
+}
+
+// Per-instance vectors, all handled by uart_isr
+#pragma vector = USCI_A0_VECTOR
+__interrupt void uart_A0_ISR(void) {
+    uart_isr(&uart_ports[0]);
+}
+
+#pragma vector = USCI_A1_VECTOR
+__interrupt void uart_A1_ISR(void) {
+    uart_isr(&uart_ports[1]);
+}
+
+// Timer A0 ISR (once a second): snapshot the throughput of every port
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void Timer_A_ISR(void) {
+    unsigned char i;
+    for (i = 0; i < UART_PORTS; i++) {
+        struct uart_port *port = &uart_ports[i];
+        unsigned int tx = port->stats.tx_bytes;   // UART ISRs can't run in here, so this is consistent
+        unsigned int rx = port->stats.rx_bytes;
+        port->stats.tx_rate = tx - port->last_tx_bytes;
+        port->stats.rx_rate = rx - port->last_rx_bytes;
+        port->last_tx_bytes = tx;
+        port->last_rx_bytes = rx;
+    }
+    second_elapsed = 1;
+    __bic_SR_register_on_exit(LPM0_bits);  // Wake main to send the report
+}
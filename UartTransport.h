@@ -0,0 +1,154 @@
+// Interrupt-driven UART transport for the eUSCI_A instances: each port has its
+// own RX and TX queues and statistics, and one handler serves every instance's
+// vector. Include after msp430fr5739.h; the functions are static inline, so
+// every program (or translation unit) that includes it gets its own copy
+
+#ifndef UART_TRANSPORT_H
+#define UART_TRANSPORT_H
+
+// Byte offsets of the eUSCI_A UART registers from UCAxCTLW0 (same layout for every instance)
+#define UART_CTLW0 0x00
+#define UART_BRW 0x06
+#define UART_MCTLW 0x08
+#define UART_STATW 0x0A
+#define UART_RXBUF 0x0C
+#define UART_TXBUF 0x0E
+#define UART_IE 0x1A
+#define UART_IFG 0x1C
+#define UART_IV 0x1E
+
+// Access one register of a port's eUSCI_A instance (the registers are 16 bits wide)
+#define UART_REG(port, offset) ((port)->regs[(offset) / 2])
+
+// Queue sizes per port (power of two so indexes wrap with a mask)
+#define UART_RX_SIZE 32
+#define UART_TX_SIZE 64
+#define UART_RX_MASK (UART_RX_SIZE - 1)
+#define UART_TX_MASK (UART_TX_SIZE - 1)
+
+// Per-port statistics
+struct uart_stats {
+    unsigned int rx_bytes;                 // Bytes received
+    unsigned int tx_bytes;                 // Bytes sent
+    unsigned int rx_dropped;               // Bytes lost because the RX queue was full
+    unsigned int rx_errors;                // Overrun or framing errors reported by the eUSCI
+    unsigned int tx_rate;                  // Bytes sent in the last second
+    unsigned int rx_rate;                  // Bytes received in the last second
+};
+
+// One UART port: an eUSCI_A instance with its own queues and statistics
+struct uart_port {
+    volatile unsigned int *regs;           // &UCAxCTLW0 of the instance
+    void (*rx_handler)(unsigned char data); // Called by the ISR with each received byte instead of queuing it (0 = queue)
+    unsigned char rx_buffer[UART_RX_SIZE];
+    volatile unsigned char rx_head;        // Only advanced by the ISR
+    volatile unsigned char rx_tail;        // Only advanced by main
+    unsigned char tx_buffer[UART_TX_SIZE];
+    volatile unsigned char tx_head;        // Only advanced by uart_write, with interrupts off
+    volatile unsigned char tx_tail;        // Only advanced by the ISR
+    struct uart_stats stats;
+    unsigned int last_tx_bytes;            // Counters at the previous one second tick
+    unsigned int last_rx_bytes;
+};
+
+// Hold a port's eUSCI in reset, e.g. while its clock changes
+static inline void uart_suspend(struct uart_port *port) {
+    UART_REG(port, UART_CTLW0) |= UCSWRST;
+}
+
+// Set the baud rate registers and release the eUSCI from reset. Reset cleared
+// the interrupt enables and set TXIFG, so queued bytes carry on going out
+static inline void uart_resume(struct uart_port *port, unsigned int brw, unsigned int mctlw) {
+    UART_REG(port, UART_CTLW0) |= UCSWRST;          // Put UART in reset mode
+    UART_REG(port, UART_BRW) = brw;                 // Baud rate divisor
+    UART_REG(port, UART_MCTLW) = mctlw;             // Modulation
+    UART_REG(port, UART_CTLW0) &= ~UCSWRST;         // Release UART from reset
+    UART_REG(port, UART_IE) |= UCRXIE;              // Enable Rx interrupt (Tx is enabled while data is queued)
+    if (port->tx_head != port->tx_tail) UART_REG(port, UART_IE) |= UCTXIE;
+}
+
+// Set up one eUSCI_A instance as a UART with the given baud rate registers
+static inline void uart_init(struct uart_port *port, volatile unsigned int *regs, unsigned int brw, unsigned int mctlw) {
+    port->regs = regs;
+    port->rx_handler = 0;
+    port->rx_head = port->rx_tail = 0;
+    port->tx_head = port->tx_tail = 0;
+
+    UART_REG(port, UART_CTLW0) |= UCSWRST;          // Put UART in reset mode
+    UART_REG(port, UART_CTLW0) |= UCSSEL__SMCLK;    // Use SMCLK (1 MHz after division)
+    uart_resume(port, brw, mctlw);
+}
+
+// Take one received byte from a port's RX queue. Returns 0 if the queue is empty
+static inline unsigned char uart_read(struct uart_port *port, unsigned char *data) {
+    if (port->rx_head == port->rx_tail) return 0;
+    *data = port->rx_buffer[port->rx_tail & UART_RX_MASK];
+    port->rx_tail++;
+    return 1;
+}
+
+// Queue one byte for transmission on a port. Returns 0 if the TX queue is full.
+// Safe from main and from ISRs
+static inline unsigned char uart_write(struct uart_port *port, unsigned char data) {
+    unsigned short state = __get_interrupt_state();
+    unsigned char queued = 0;
+
+    __disable_interrupt();
+    if ((unsigned char)(port->tx_head - port->tx_tail) < UART_TX_SIZE) {
+        port->tx_buffer[port->tx_head & UART_TX_MASK] = data;
+        port->tx_head++;
+        if (!(UART_REG(port, UART_IE) & UCTXIE)) {
+            // Transmitter idle: the ISR's UCAxIV read cleared TXIFG when it turned
+            // itself off, so raise the flag again to get the first interrupt
+            UART_REG(port, UART_IFG) |= UCTXIFG;
+            UART_REG(port, UART_IE) |= UCTXIE;
+        }
+        queued = 1;
+    }
+    __set_interrupt_state(state);
+    return queued;
+}
+
+// Free space in a port's TX queue
+static inline unsigned char uart_tx_space(struct uart_port *port) {
+    return UART_TX_SIZE - (unsigned char)(port->tx_head - port->tx_tail);
+}
+
+// Shared interrupt handler, called from each instance's vector. Reading UCAxIV
+// clears the flag it reports
+static inline void uart_isr(struct uart_port *port) {
+    switch (__even_in_range(UART_REG(port, UART_IV), USCI_UART_UCTXIFG)) {
+        case USCI_UART_UCRXIFG:
+        {
+            if (UART_REG(port, UART_STATW) & (UCOE | UCFE)) {
+                port->stats.rx_errors++;           // Reading RXBUF below clears these flags
+            }
+            unsigned char data = UART_REG(port, UART_RXBUF);
+            port->stats.rx_bytes++;
+            if (port->rx_handler) {
+                port->rx_handler(data);
+            } else if ((unsigned char)(port->rx_head - port->rx_tail) >= UART_RX_SIZE) {
+                port->stats.rx_dropped++;          // Queue full: count the lost byte
+            } else {
+                port->rx_buffer[port->rx_head & UART_RX_MASK] = data;
+                port->rx_head++;
+            }
+            __bic_SR_register_on_exit(LPM0_bits);  // Wake main to handle the byte
+            break;
+        }
+        case USCI_UART_UCTXIFG:
+            if (port->tx_head == port->tx_tail) {
+                UART_REG(port, UART_IE) &= ~UCTXIE; // Nothing left to send; uart_write restarts it
+            } else {
+                UART_REG(port, UART_TXBUF) = port->tx_buffer[port->tx_tail & UART_TX_MASK];
+                port->tx_tail++;
+                port->stats.tx_bytes++;
+                __bic_SR_register_on_exit(LPM0_bits); // Wake main to refill the queue
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+#endif
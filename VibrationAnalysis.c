@@ -0,0 +1,351 @@
+#include "msp430fr5739.h"
+
+// Define the data packet start byte
+#define START_BYTE 255
+
+// Accelerometer axis to analyse (X: A12, Y: A13, Z: A14)
+#define VIBRATION_CHANNEL ADC10INCH_12
+
+// Sampling: Timer_A0 output TA0.1 triggers every conversion (1 kHz at SMCLK 1 MHz)
+#define SAMPLE_PERIOD 1000
+#define SAMPLE_HZ (1000000UL / SAMPLE_PERIOD)
+#define ADC_CONVERSION_TICKS 28
+
+#if SAMPLE_PERIOD < ADC_CONVERSION_TICKS
+#error "SAMPLE_PERIOD is shorter than one ADC10 conversion"
+#endif
+
+// Block size for the FFT and the Goertzel detectors (bin width = SAMPLE_HZ / FFT_SIZE)
+#define FFT_SIZE 64
+#define FFT_STAGES 6                       // log2(FFT_SIZE)
+#define INPUT_SHIFT 5                      // Scale centred 10-bit samples up to Q15 range
+
+// Goertzel detectors for known fault frequencies
+#define DETECTOR_COUNT 3
+
+// Octave bands reported from the FFT
+#define BAND_COUNT 4
+
+// Report packet types (START_BYTE, type, high byte, low byte)
+#define REPORT_PEAK_BIN 0xA0               // Strongest FFT bin (DC excluded)
+#define REPORT_PEAK_POWER 0xA1             // Power of that bin, Q15 squared >> 12
+#define REPORT_BAND 0xB0                   // 0xB0 + band: band power, Q15 squared >> 12
+#define REPORT_DETECTOR 0xC0               // 0xC0 + detector: Goertzel |X[k]|^2 >> 12
+#define REPORT_TICKS 0xCC                  // SMCLK ticks spent analysing the block
+#define REPORT_OVERRUNS 0xCD               // Blocks lost because analysis fell behind
+
+// Q15 twiddle factors cos(2*pi*k/FFT_SIZE) and sin(2*pi*k/FFT_SIZE), k = 0 .. FFT_SIZE/2 - 1
+const int fft_cos[FFT_SIZE / 2] = {
+     32767,  32610,  32138,  31357,  30274,  28899,  27246,  25330,
+     23170,  20788,  18205,  15447,  12540,   9512,   6393,   3212,
+         0,  -3212,  -6393,  -9512, -12540, -15447, -18205, -20788,
+    -23170, -25330, -27246, -28899, -30274, -31357, -32138, -32610,
+};
+
+const int fft_sin[FFT_SIZE / 2] = {
+         0,   3212,   6393,   9512,  12540,  15447,  18205,  20788,
+     23170,  25330,  27246,  28899,  30274,  31357,  32138,  32610,
+     32767,  32610,  32138,  31357,  30274,  28899,  27246,  25330,
+     23170,  20788,  18205,  15447,  12540,   9512,   6393,   3212,
+};
+
+// Fault frequencies to watch, in Hz (rounded to the nearest bin)
+const unsigned int detector_hz[DETECTOR_COUNT] = { 50, 120, 300 };
+
+// First FFT bin of each band, plus the end of the last band
+const unsigned char band_edges[BAND_COUNT + 1] = { 1, 4, 8, 16, FFT_SIZE / 2 };
+
+// Capture variables: the ADC ISR fills one block while main analyses the other
+int capture[2][FFT_SIZE];                  // Raw samples, then FFT real parts
+int fft_im[FFT_SIZE];                      // FFT imaginary parts
+unsigned char capture_block = 0;           // Block being filled by the ADC ISR
+unsigned int capture_index = 0;            // Next sample in that block
+volatile signed char ready_block = -1;     // Block waiting for main (-1 = none)
+volatile unsigned int block_overruns = 0;  // Blocks dropped because main was still busy
+
+// Every product and sum in goertzel() goes through this, so a host test can
+// check that each one fits in the 32-bit long it has on the MSP430
+#ifndef GOERTZEL_TERM
+#define GOERTZEL_TERM(value) (value)
+#endif
+
+// Goertzel detector variables (set up at startup)
+unsigned char detector_bin[DETECTOR_COUNT];
+int detector_coeff[DETECTOR_COUNT];        // 2*cos(2*pi*bin/FFT_SIZE) in Q14
+
+// Function Prototypes
+void configure_UART();
+void configure_ADC10();
+void configure_timer_trigger();
+void configure_analysis_timer();
+void configure_p2_7();
+void configure_detectors();
+void clkInit();
+unsigned int goertzel(const int *samples, unsigned char detector);
+void fft(int *re, int *im);
+void analyse_block(int *samples);
+void transmit_packet(unsigned char type, unsigned int value);
+void transmitChar(unsigned char data);
+
+// Function to configure UART with correct baud rate and settings
+void configure_UART() {
+    // Select SMCLK for UART and configure UART pins
+    P2SEL0 &= ~(BIT0 | BIT1);
+    P2SEL1 |= (BIT0 | BIT1);
+
+    UCA0CTLW0 |= UCSWRST;              // Put UART in reset mode
+    UCA0CTLW0 |= UCSSEL__SMCLK;        // Use SMCLK (1 MHz after division)
+
+    UCA0BRW = 104;                     // Set baud rate for 9600 (SMCLK 1 MHz)
+    UCA0MCTLW = 0xD600;                // Set modulation UCBRSx=0xD6, UCOS16=1
+
+    UCA0CTLW0 &= ~UCSWRST;             // Release UART from reset
+}
+
+// Function to configure ADC for timer-triggered conversions of one accelerometer axis
+void configure_ADC10() {
+    ADC10CTL0 = ADC10SHT_2 | ADC10ON;  // Sample and hold time = 16 ADC10CLK cycles, ADC on
+    ADC10CTL1 = ADC10SHS_1 | ADC10SHP | ADC10SSEL_3 | ADC10CONSEQ_2; // Trigger on TA0.1, sampling timer, SMCLK, repeat single channel
+    ADC10CTL2 = ADC10RES;              // 10-bit resolution
+    ADC10MCTL0 = VIBRATION_CHANNEL;    // Select the accelerometer axis
+    ADC10IE = ADC10IE0;                // Interrupt when a conversion result is ready
+    ADC10CTL0 |= ADC10ENC;             // Enable conversions, the timer starts each one
+}
+
+// Function to configure Timer A0 to trigger the ADC every SAMPLE_PERIOD ticks
+void configure_timer_trigger() {
+    TA0CCR0 = SAMPLE_PERIOD - 1;       // Timer period (1 ms = 1 kHz by default)
+    TA0CCR1 = SAMPLE_PERIOD / 2;       // TA0.1 falls here...
+    TA0CCTL1 = OUTMOD_7;               // ...and rises at CCR0, right before each rollover
+    TA0CTL = TASSEL_2 | MC_1 | TACLR;  // SMCLK, up mode, clear timer
+}
+
+// Free-running Timer A1 on SMCLK, used to time the analysis of each block
+void configure_analysis_timer() {
+    TA1CTL = TASSEL_2 | MC_2 | TACLR;  // SMCLK, continuous mode, clear timer
+}
+
+// Function to power accelerometer via P2.7
+void configure_p2_7() {
+    P2DIR |= BIT7;                     // Set P2.7 as output
+    P2OUT |= BIT7;                     // Set P2.7 high to power accelerometer
+}
+
+// Map each fault frequency to its nearest bin and Goertzel coefficient
+void configure_detectors() {
+    unsigned char i;
+    for (i = 0; i < DETECTOR_COUNT; i++) {
+        unsigned int bin = ((unsigned long)detector_hz[i] * FFT_SIZE + SAMPLE_HZ / 2) / SAMPLE_HZ;
+        if (bin >= FFT_SIZE / 2) bin = FFT_SIZE / 2 - 1;   // Clamp to below Nyquist
+        detector_bin[i] = bin;
+        detector_coeff[i] = fft_cos[bin];                  // cos in Q15 is 2*cos in Q14
+    }
+}
+
+// Goertzel power of one detector's bin over a block of centred samples
+// Returns |X[k]|^2 >> 12, saturated to 16 bits
+unsigned int goertzel(const int *samples, unsigned char detector) {
+    long coeff = detector_coeff[detector];
+    long s1 = 0, s2 = 0, power;
+    unsigned char shift = 0;
+    unsigned int i;
+
+    // s1 reaches about FFT_SIZE * 1023 / sin(2*pi*bin/FFT_SIZE), 2^18 at bin 3, so
+    // coeff * s1 would need 34 bits: multiply the parts above and below bit 14 separately
+    for (i = 0; i < FFT_SIZE; i++) {
+        long high = GOERTZEL_TERM(coeff * (s1 >> 14));
+        long low = GOERTZEL_TERM(coeff * (s1 & 0x3FFF)) >> 14;
+        long s0 = GOERTZEL_TERM(samples[i] + high + low - s2);
+        s2 = s1;
+        s1 = s0;
+    }
+
+    // |X[k]|^2 = s1^2 + s2^2 - coeff*s1*s2. Halve s1 and s2 until both fit in
+    // 15 bits so every term fits in 32 bits, and put the scale back afterwards
+    while (s1 >= 0x4000 || s1 < -0x4000 || s2 >= 0x4000 || s2 < -0x4000) {
+        s1 >>= 1;
+        s2 >>= 1;
+        shift += 2;
+    }
+    power = GOERTZEL_TERM(GOERTZEL_TERM(s1 * s1) + GOERTZEL_TERM(s2 * s2)
+                          - GOERTZEL_TERM(GOERTZEL_TERM(coeff * s1) >> 14) * s2);
+
+    if (power <= 0) return 0;
+    if (shift < 12) {
+        power >>= 12 - shift;
+    } else if (power > (0xFFFFL >> (shift - 12))) {
+        return 0xFFFF;                     // Would not fit even before scaling back up
+    } else {
+        power <<= shift - 12;
+    }
+    return (power > 0xFFFF) ? 0xFFFF : power;
+}
+
+// In-place radix-2 decimation-in-time FFT in Q15.
+// Every stage halves its outputs, so the result is X[k] / FFT_SIZE and never overflows
+void fft(int *re, int *im) {
+    unsigned int i, j, k, bit, half, step;
+
+    // Bit-reversal permutation
+    for (i = 1, j = 0; i < FFT_SIZE; i++) {
+        for (bit = FFT_SIZE >> 1; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            int t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    // Butterflies
+    for (half = 1, step = FFT_SIZE / 2; half < FFT_SIZE; half <<= 1, step >>= 1) {
+        for (k = 0; k < half; k++) {
+            long wr = fft_cos[k * step];
+            long wi = -fft_sin[k * step];
+            for (i = k; i < FFT_SIZE; i += half << 1) {
+                j = i + half;
+                // Sums of two Q15 values need 17 bits, so add in long and halve before storing
+                long tr = (wr * re[j] - wi * im[j]) >> 15;
+                long ti = (wr * im[j] + wi * re[j]) >> 15;
+                re[j] = (re[i] - tr) >> 1;
+                im[j] = (im[i] - ti) >> 1;
+                re[i] = (re[i] + tr) >> 1;
+                im[i] = (im[i] + ti) >> 1;
+            }
+        }
+    }
+}
+
+// Analyse one captured block and send only the summary, never the raw samples
+void analyse_block(int *samples) {
+    unsigned int start = TA1R;
+    unsigned int detector_power[DETECTOR_COUNT];
+    unsigned long band_power[BAND_COUNT];
+    unsigned long peak_power = 0;
+    unsigned char peak_bin = 0;
+    long mean = 0;
+    unsigned int i;
+    unsigned char band;
+
+    // Remove the DC offset (gravity and the 1.65 V bias) before looking at vibration
+    for (i = 0; i < FFT_SIZE; i++) {
+        mean += samples[i];
+    }
+    mean /= FFT_SIZE;
+    for (i = 0; i < FFT_SIZE; i++) {
+        samples[i] -= mean;
+    }
+
+    for (i = 0; i < DETECTOR_COUNT; i++) {
+        detector_power[i] = goertzel(samples, i);
+    }
+
+    // FFT in place: the samples become the real parts
+    for (i = 0; i < FFT_SIZE; i++) {
+        samples[i] <<= INPUT_SHIFT;
+        fft_im[i] = 0;
+    }
+    fft(samples, fft_im);
+
+    // Band powers and the strongest bin
+    band = 0;
+    band_power[0] = 0;
+    for (i = band_edges[0]; i < FFT_SIZE / 2; i++) {
+        unsigned long power = (long)samples[i] * samples[i] + (long)fft_im[i] * fft_im[i];
+        while (i >= band_edges[band + 1]) {
+            band_power[++band] = 0;
+        }
+        band_power[band] += power;
+        if (power > peak_power) {
+            peak_power = power;
+            peak_bin = i;
+        }
+    }
+
+    unsigned int ticks = TA1R - start;
+
+    transmit_packet(REPORT_PEAK_BIN, peak_bin);
+    transmit_packet(REPORT_PEAK_POWER, (peak_power >> 12) > 0xFFFF ? 0xFFFF : peak_power >> 12);
+    for (band = 0; band < BAND_COUNT; band++) {
+        transmit_packet(REPORT_BAND + band, (band_power[band] >> 12) > 0xFFFF ? 0xFFFF : band_power[band] >> 12);
+    }
+    for (i = 0; i < DETECTOR_COUNT; i++) {
+        transmit_packet(REPORT_DETECTOR + i, detector_power[i]);
+    }
+    transmit_packet(REPORT_TICKS, ticks);
+    transmit_packet(REPORT_OVERRUNS, block_overruns);
+}
+
+// Transmit a report packet (start byte, type, value high byte, value low byte)
+void transmit_packet(unsigned char type, unsigned int value) {
+    transmitChar(START_BYTE);
+    transmitChar(type);
+    transmitChar(value >> 8);
+    transmitChar(value & 0xFF);
+}
+
+// Helper function to transmit a character via UART
+void transmitChar(unsigned char data) {
+    while (!(UCA0IFG & UCTXIFG));       // Wait for transmit buffer to be ready
+    UCA0TXBUF = data;                   // Transmit character
+}
+
+// ADC10 ISR (triggered when a timer-started conversion completes)
+#pragma vector = ADC10_VECTOR
+__interrupt void ADC10_ISR(void) {
+    switch (__even_in_range(ADC10IV, ADC10IV_ADC10IFG)) {
+        case ADC10IV_ADC10IFG:
+            capture[capture_block][capture_index] = ADC10MEM0; // 10-bit result
+            if (++capture_index == FFT_SIZE) {
+                capture_index = 0;
+                if (ready_block >= 0) {
+                    block_overruns++;           // Main still busy: refill this block
+                } else {
+                    ready_block = capture_block;
+                    capture_block ^= 1;         // Fill the other block next
+                    __bic_SR_register_on_exit(LPM0_bits); // Wake main to analyse the block
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Clock initialization (SMCLK = 1 MHz)
+void clkInit() {
+    CSCTL0 = 0xA500;                  // Write password to modify CS registers
+    CSCTL1 = DCOFSEL_3;               // Set DCO to 8 MHz
+    CSCTL2 = SELM__DCOCLK | SELS__DCOCLK | SELA__DCOCLK;  // Set MCLK, SMCLK, ACLK to DCO
+    CSCTL3 = DIVA__8 | DIVS__8;       // Divide SMCLK and ACLK by 8 (1 MHz)
+    CSCTL0_H = 0;                     // Lock CS registers
+}
+
+int main(void) {
+    WDTCTL = WDTPW | WDTHOLD;         // Stop watchdog timer
+
+    clkInit();                        // Initialize clocks
+    configure_detectors();            // Map fault frequencies to bins
+    configure_p2_7();                 // Power accelerometer using P2.7
+    configure_UART();                 // Set up UART for 9600 baud
+    configure_analysis_timer();       // Time each block's analysis
+    configure_ADC10();                // Set up ADC for the accelerometer axis
+    configure_timer_trigger();        // Set up Timer A to trigger the ADC
+
+    __bis_SR_register(GIE);           // Enable global interrupts
+
+    while (1) {
+        __disable_interrupt();        // Check for a block with interrupts off so no wake-up is missed
+        if (ready_block < 0) {
+            __bis_SR_register(LPM0_bits | GIE); // Sleep until a block is captured
+        } else {
+            __enable_interrupt();
+        }
+
+        if (ready_block >= 0) {
+            analyse_block(capture[ready_block]);
+            ready_block = -1;         // Block is free for the ADC ISR again
+        }
+    }
+}
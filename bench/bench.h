@@ -0,0 +1,87 @@
+// Minimal host microbenchmark harness.
+//
+// Each benchmark is a function that runs its hot path a given number of times.
+// The harness grows the repeat count until one run takes BENCH_MIN_NS, takes
+// the fastest of BENCH_SAMPLES runs (the least disturbed by the host), and
+// reports the cost relative to a fixed reference kernel timed alongside it.
+// The relative cost is what the baseline stores: it follows changes to the
+// code under test but mostly cancels out the speed of the machine.
+//
+// Output is one line per benchmark, read by bench/compare.cmake:
+//     BENCH <name> <cost in thousandths of the reference> <ns per operation>
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_SAMPLES 21
+#define BENCH_MIN_NS 2000000.0              // 2 ms per sample
+
+typedef void (*bench_fn)(unsigned long repeats);
+
+static volatile unsigned int bench_sink;    // Keeps results alive past the optimizer
+
+static double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Grow the repeat count until one call of fn(repeats) takes BENCH_MIN_NS
+static unsigned long bench_calibrate(bench_fn fn) {
+    unsigned long repeats = 1;
+    for (;;) {
+        double start = bench_now_ns();
+        fn(repeats);
+        if (bench_now_ns() - start >= BENCH_MIN_NS) return repeats;
+        repeats *= 2;
+    }
+}
+
+// Time of one call of fn(repeats) in ns
+static double bench_sample(bench_fn fn, unsigned long repeats) {
+    double start = bench_now_ns();
+    fn(repeats);
+    return (bench_now_ns() - start) / repeats;
+}
+
+// Reference kernel: a dependent chain of loads, stores and branches on a small
+// table, roughly the mix of the firmware hot paths
+static void bench_reference(unsigned long repeats) {
+    static volatile unsigned char table[64];
+    unsigned int state = 1;
+    while (repeats--) {
+        unsigned int i;
+        for (i = 0; i < 16; i++) {
+            state = state * 75 + 74;
+            if (state & 0x100) {
+                table[state & 63]++;
+            } else {
+                state ^= table[(state >> 3) & 63];
+            }
+        }
+    }
+    bench_sink = state;
+}
+
+// Time fn, where each call performs ops operations, and print its BENCH line.
+// Reference and benchmark samples alternate so both see the same clock speed
+static void bench_report(const char *name, bench_fn fn, unsigned long ops) {
+    unsigned long reference_repeats = bench_calibrate(bench_reference);
+    unsigned long repeats = bench_calibrate(fn);
+    double reference_ns = 0, ns = 0;
+    int i;
+
+    for (i = 0; i < BENCH_SAMPLES; i++) {
+        double reference_sample = bench_sample(bench_reference, reference_repeats);
+        double sample = bench_sample(fn, repeats) / ops;
+        if (i == 0 || reference_sample < reference_ns) reference_ns = reference_sample;
+        if (i == 0 || sample < ns) ns = sample;
+    }
+    printf("BENCH %s %.0f %.2f\n", name, 1000.0 * ns / reference_ns, ns);
+    fflush(stdout);
+}
+
+#endif
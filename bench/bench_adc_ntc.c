@@ -0,0 +1,35 @@
+// Microbenchmarks for the ADCNTCExternalConfig.c LED bar and sample path
+
+#define main firmware_main
+#include "ADCNTCExternalConfig.c"
+#undef main
+
+#include "bench.h"
+
+// Sweep the temperature across every LED threshold
+static void leds(unsigned long repeats) {
+    while (repeats--) {
+        unsigned char temp;
+        for (temp = 176; temp < 196; temp++) update_LEDs(temp);
+    }
+}
+
+// Four conversions through the ADC ISR, then main drains and transmits them
+static void sample_path(unsigned long repeats) {
+    ADC10IV = ADC10IV_ADC10IFG;
+    while (repeats--) {
+        unsigned char i;
+        for (i = 0; i < 4; i++) {
+            ADC10MEM0 = 720 + i;
+            ADC10_ISR();
+        }
+        drain_samples();
+    }
+}
+
+int main(void) {
+    host_reset();
+    bench_report("ntc.update_LEDs", leds, 20);
+    bench_report("ntc.adc_isr_drain", sample_path, 4);
+    return 0;
+}
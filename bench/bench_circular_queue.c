@@ -0,0 +1,38 @@
+// Microbenchmarks for the CircularQueue.c ring buffer and echo ISR
+
+#define main firmware_main
+#include "CircularQueue.c"
+#undef main
+
+#include "bench.h"
+
+// Fill the buffer part way and empty it again
+static void add_remove(unsigned long repeats) {
+    while (repeats--) {
+        unsigned char i;
+        for (i = 0; i < 32; i++) circular_buffer_add(i);
+        for (i = 0; i < 32; i++) bench_sink += circular_buffer_remove();
+    }
+}
+
+// Whole receive path: seven characters, then a carriage return that echoes one back
+static void uart_isr_path(unsigned long repeats) {
+    while (repeats--) {
+        unsigned char i;
+        for (i = 0; i < 8; i++) {
+            UCA0RXBUF = (i == 7) ? 13 : 'a' + i;
+            UCA0IV = USCI_UART_UCRXIFG;  // What the ISR's UCA0IV read returns for a received byte
+            uart_ISR();
+        }
+        while (count) circular_buffer_remove();
+        uart.tx_tail = uart.tx_head;    // Drop the echo rather than timing the transmitter
+    }
+}
+
+int main(void) {
+    host_reset();
+    configure_UART();
+    bench_report("circular_queue.add_remove", add_remove, 64);
+    bench_report("circular_queue.uart_isr", uart_isr_path, 8);
+    return 0;
+}
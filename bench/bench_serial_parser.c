@@ -0,0 +1,60 @@
+// Microbenchmarks for the SerialCommunicator.c queue and packet parser
+
+#define main firmware_main
+#include "SerialCommunicator.c"
+#undef main
+
+#include "bench.h"
+
+// Received stream: LED on/off, two timer periods (one escaped) and line noise
+static const unsigned char stream[] = {
+    0xFF, 0x02, 0x00, 0x00, 0x00,
+    0x13, 0x37,
+    0xFF, 0x01, 0x12, 0x34, 0x00,
+    0xFF, 0x03, 0x00, 0x00, 0x00,
+    0xFF, 0x55,
+    0xFF, 0x01, 0x00, 0x00, 0x02,
+};
+
+static void add_remove(unsigned long repeats) {
+    while (repeats--) {
+        unsigned char i;
+        for (i = 0; i < 32; i++) circular_buffer_add(i);
+        for (i = 0; i < 32; i++) bench_sink += circular_buffer_remove();
+    }
+}
+
+// Read every queued byte through peek, with the ring wrapped around
+static void peek(unsigned long repeats) {
+    unsigned int i;
+    while (count) circular_buffer_remove();
+    for (i = 0; i < 30; i++) circular_buffer_add(0);
+    for (i = 0; i < 30; i++) circular_buffer_remove();
+    for (i = 0; i < 40; i++) circular_buffer_add(i);
+    while (repeats--) {
+        for (i = 0; i < 40; i++) bench_sink += circular_buffer_peek(i);
+    }
+}
+
+// Feed the stream through the UART ISR and parse it
+static void parse(unsigned long repeats) {
+    while (repeats--) {
+        unsigned int i;
+        for (i = 0; i < sizeof(stream); i++) {
+            UCA0RXBUF = stream[i];
+            UCA0IV = USCI_UART_UCRXIFG;  // What the ISR's UCA0IV read returns for a received byte
+            uart_ISR();
+        }
+        process_packets();
+        uart.tx_tail = uart.tx_head;    // Drop the responses rather than timing the transmitter
+    }
+}
+
+int main(void) {
+    host_reset();
+    configure_UART();
+    bench_report("serial.add_remove", add_remove, 64);
+    bench_report("serial.peek", peek, 40);
+    bench_report("serial.process_packets", parse, sizeof(stream));
+    return 0;
+}
@@ -0,0 +1,7 @@
+# Run msp430_cycles on a recorded disassembly and compare with the expected report
+# (hand-checked against the instruction cycle table)
+execute_process(COMMAND ${TOOL} sample.o INPUT_FILE ${INPUT} OUTPUT_VARIABLE output RESULT_VARIABLE status)
+file(READ ${EXPECTED} expected)
+if(NOT status EQUAL 0 OR NOT output STREQUAL expected)
+  message(FATAL_ERROR "msp430_cycles output differs from ${EXPECTED}:\n${output}")
+endif()
@@ -0,0 +1,113 @@
+# Run the host benchmarks and compare them with the recorded baseline.
+#
+# cmake -DBENCH_PROGRAMS=a|b|c -DBASELINE=baseline.json -DRESULTS=results.json
+#       -DTHRESHOLD=<percent> [-DRUNS=<n>] [-DUPDATE_BASELINE=ON] -P compare.cmake
+#
+# Each program runs RUNS times (default 5) and the lowest cost is kept: code
+# layout and load from other machines move the host timings by up to a third
+# from one process to the next. A benchmark over THRESHOLD percent above its
+# baseline is measured again, up to CONFIRM_ROUNDS more rounds, and the run
+# fails if it is still over (or if a baseline entry has no result). A real
+# regression survives the extra rounds, a burst of host load doesn't.
+#
+# The results are written to RESULTS in the same format as the baseline. With
+# UPDATE_BASELINE they replace the baseline instead.
+
+cmake_minimum_required(VERSION 3.19)
+
+string(REPLACE "|" ";" programs "${BENCH_PROGRAMS}")
+if(NOT RUNS)
+  set(RUNS 5)
+endif()
+set(CONFIRM_ROUNDS 3)
+set(names)
+
+# Run every program RUNS times, keeping the lowest cost seen for each benchmark
+macro(measure)
+  foreach(program IN LISTS programs)
+    foreach(run RANGE 1 ${RUNS})
+      execute_process(COMMAND ${program} OUTPUT_VARIABLE output RESULT_VARIABLE status)
+      if(NOT status EQUAL 0)
+        message(FATAL_ERROR "${program} failed: ${status}")
+      endif()
+      string(REGEX MATCHALL "BENCH [^\n]+" lines "${output}")
+      foreach(line IN LISTS lines)
+        string(REGEX REPLACE "^BENCH ([^ ]+) ([0-9]+) ([0-9.]+)$" "\\1;\\2;\\3" fields "${line}")
+        list(GET fields 0 name)
+        list(GET fields 1 cost)
+        list(GET fields 2 ns)
+        if(NOT DEFINED cost_${name})
+          list(APPEND names ${name})
+        endif()
+        if(NOT DEFINED cost_${name} OR cost LESS cost_${name})
+          set(cost_${name} ${cost})
+          set(ns_${name} ${ns})
+        endif()
+      endforeach()
+    endforeach()
+  endforeach()
+endmacro()
+
+# Write the current results to RESULTS
+macro(write_results)
+  set(json "{\n  \"threshold_percent\": ${THRESHOLD},\n  \"benchmarks\": {")
+  set(separator "")
+  foreach(name IN LISTS names)
+    string(APPEND json "${separator}\n    \"${name}\": { \"cost\": ${cost_${name}}, \"ns_per_op\": ${ns_${name}} }")
+    set(separator ",")
+  endforeach()
+  string(APPEND json "\n  }\n}\n")
+  file(WRITE ${RESULTS} "${json}")
+endmacro()
+
+# Compare with the baseline: sets regressed to the benchmarks over the threshold
+macro(compare report)
+  set(regressed)
+  foreach(index RANGE ${last})
+    string(JSON name MEMBER "${baseline}" benchmarks ${index})
+    string(JSON base GET "${baseline}" benchmarks ${name} cost)
+    if(NOT DEFINED cost_${name})
+      message(FATAL_ERROR "${name}: in the baseline but not measured")
+    endif()
+    math(EXPR limit "${base} * (100 + ${THRESHOLD}) / 100")
+    math(EXPR change "(${cost_${name}} - ${base}) * 100 / ${base}")
+    set(line "${name}: cost ${cost_${name}} (baseline ${base}, ${change}%), ${ns_${name}} ns/op")
+    if(cost_${name} GREATER limit)
+      list(APPEND regressed ${name})
+      if(${report})
+        message(SEND_ERROR "REGRESSION ${line}")
+      endif()
+    elseif(${report})
+      message(STATUS "${line}")
+    endif()
+  endforeach()
+endmacro()
+
+measure()
+write_results()
+
+if(UPDATE_BASELINE)
+  file(WRITE ${BASELINE} "${json}")
+  message(STATUS "Baseline written to ${BASELINE}")
+  return()
+endif()
+
+file(READ ${BASELINE} baseline)
+string(JSON count LENGTH "${baseline}" benchmarks)
+math(EXPR last "${count} - 1")
+
+compare(OFF)
+foreach(round RANGE 1 ${CONFIRM_ROUNDS})
+  if(NOT regressed)
+    break()
+  endif()
+  message(STATUS "Over the threshold, measuring again: ${regressed}")
+  measure()
+  compare(OFF)
+endforeach()
+
+write_results()
+compare(ON)
+if(regressed)
+  message(FATAL_ERROR "Benchmarks regressed more than ${THRESHOLD}% (results in ${RESULTS})")
+endif()
@@ -0,0 +1,8 @@
+// Forced include for the msp430-elf-gcc size and cycle report. The firmware is
+// written for the TI compiler: give its ISR keyword a gcc meaning (the vector
+// pragmas are ignored, which doesn't change the code generated for a function)
+#include <msp430.h>
+
+#ifndef __interrupt
+#define __interrupt __attribute__((interrupt))
+#endif
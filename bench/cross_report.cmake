@@ -0,0 +1,56 @@
+# Cross-compile every firmware image with msp430-elf-gcc and report per-function
+# code size and static cycle estimates.
+#
+# Writes OUTPUT_DIR/<image>.json for each image and OUTPUT_DIR/cross_report.json
+# with all of them, and prints the biggest functions of each image.
+
+cmake_minimum_required(VERSION 3.19)
+
+string(REPLACE "|" ";" sources "${SOURCES}")
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+set(report "[")
+set(separator "")
+
+foreach(source IN LISTS sources)
+  get_filename_component(image ${source} NAME_WE)
+  set(object ${OUTPUT_DIR}/${image}.o)
+
+  execute_process(
+    COMMAND ${MSP430_GCC} -mmcu=msp430fr5739 -Os -ffunction-sections -Wno-unknown-pragmas
+            -I${SUPPORT_INCLUDE} -include ${COMPAT} -c ${source} -o ${object}
+    RESULT_VARIABLE status ERROR_VARIABLE errors)
+  if(NOT status EQUAL 0)
+    message(WARNING "${image}: cross build failed\n${errors}")
+    continue()
+  endif()
+
+  execute_process(
+    COMMAND ${MSP430_OBJDUMP} -d ${object}
+    COMMAND ${CYCLES_TOOL} ${image}
+    OUTPUT_VARIABLE json RESULT_VARIABLE status)
+  if(NOT status EQUAL 0)
+    message(WARNING "${image}: could not disassemble")
+    continue()
+  endif()
+  file(WRITE ${OUTPUT_DIR}/${image}.json "${json}")
+  string(APPEND report "${separator}\n${json}")
+  set(separator ",")
+
+  string(JSON count LENGTH "${json}" functions)
+  set(total 0)
+  if(count GREATER 0)
+    math(EXPR last "${count} - 1")
+    foreach(index RANGE ${last})
+      string(JSON name GET "${json}" functions ${index} name)
+      string(JSON bytes GET "${json}" functions ${index} bytes)
+      string(JSON cycles GET "${json}" functions ${index} cycles)
+      math(EXPR total "${total} + ${bytes}")
+      message(STATUS "${image}: ${name} ${bytes} bytes, ~${cycles} cycles straight-line")
+    endforeach()
+  endif()
+  message(STATUS "${image}: ${total} bytes of code")
+endforeach()
+
+string(APPEND report "\n]\n")
+file(WRITE ${OUTPUT_DIR}/cross_report.json "${report}")
+message(STATUS "Cross report written to ${OUTPUT_DIR}/cross_report.json")
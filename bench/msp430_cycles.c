@@ -0,0 +1,257 @@
+// Static per-function code size and cycle estimate from msp430-elf-objdump -d.
+//
+//     msp430-elf-objdump -d image.o | msp430_cycles <label>
+//
+// Prints one JSON object: {"file": label, "functions": [{name, bytes,
+// instructions, cycles, unknown}, ...]}. "cycles" is the sum of every
+// instruction's cycle count on the MSP430X CPU (FR57xx family user's guide,
+// instruction cycles and lengths), so it is a straight-line cost: loops run
+// once and both sides of every branch are counted. "unknown" counts
+// instructions outside the table, which are charged 2 cycles.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE 512
+#define MAX_NAME 128
+
+enum mode { REG, CGEN, IMM, IND, INC, IDX, ABS };
+
+struct function {
+    char name[MAX_NAME];
+    unsigned long bytes;
+    unsigned long instructions;
+    unsigned long cycles;
+    unsigned long unknown;
+};
+
+static int is_register(const char *op) {
+    if (!strcmp(op, "sp") || !strcmp(op, "pc") || !strcmp(op, "sr") || !strcmp(op, "cg")) return 1;
+    if (op[0] != 'r' || !isdigit((unsigned char)op[1])) return 0;
+    return op[2] == '\0' || (isdigit((unsigned char)op[2]) && op[3] == '\0');
+}
+
+static int is_pc(const char *op) {
+    return !strcmp(op, "pc") || !strcmp(op, "r0");
+}
+
+static enum mode operand_mode(const char *op) {
+    if (op[0] == '#') {
+        long value = strtol(op + 1, NULL, 0);
+        // The constant generators supply these without an extension word
+        if (value == 0 || value == 1 || value == 2 || value == 4 || value == 8 || value == -1) return CGEN;
+        return IMM;
+    }
+    if (op[0] == '@') return op[strlen(op) - 1] == '+' ? INC : IND;
+    if (op[0] == '&') return ABS;
+    if (strchr(op, '(')) return IDX;
+    if (is_register(op)) return REG;
+    return IDX;                              // Symbolic: PC-relative indexed
+}
+
+static int is_memory(enum mode mode) {
+    return mode == IDX || mode == ABS;
+}
+
+// Two-operand (format I) instruction
+static unsigned int format_one(const char *mnemonic, enum mode src, const char *dst_op) {
+    enum mode dst = operand_mode(dst_op);
+    unsigned int src_cost = (src == REG || src == CGEN) ? 0 : is_memory(src) ? 2 : 1;
+
+    if (!is_memory(dst)) {
+        return 1 + src_cost + (is_pc(dst_op) ? 1 : 0);
+    }
+    // MOV, BIT and CMP don't write the destination back
+    if (!strcmp(mnemonic, "mov") || !strcmp(mnemonic, "bit") || !strcmp(mnemonic, "cmp")) {
+        return 3 + src_cost;
+    }
+    return 4 + src_cost;
+}
+
+// Single-operand (format II) instruction
+static unsigned int format_two(const char *mnemonic, enum mode mode) {
+    if (!strcmp(mnemonic, "push")) return is_memory(mode) ? 4 : 3;
+    if (!strcmp(mnemonic, "call")) return mode == ABS ? 6 : mode == IDX ? 5 : 4;
+    return mode == REG ? 1 : is_memory(mode) ? 4 : 3;   // rra, rrc, swpb, sxt
+}
+
+static int in_list(const char *word, const char *const *list) {
+    for (; *list; list++) {
+        if (!strcmp(word, *list)) return 1;
+    }
+    return 0;
+}
+
+static const char *const format_one_ops[] = {
+    "mov", "add", "addc", "subc", "sub", "cmp", "dadd", "bit", "bic", "bis", "xor", "and", NULL
+};
+static const char *const format_two_ops[] = { "rra", "rrc", "swpb", "sxt", "push", "call", NULL };
+static const char *const jump_ops[] = {
+    "jmp", "jne", "jnz", "jeq", "jz", "jnc", "jlo", "jc", "jhs", "jn", "jge", "jl", NULL
+};
+// Emulated instructions with a constant-generator source: clr = mov #0, inc = add #1, ...
+static const char *const cgen_ops[] = {
+    "clr", "inc", "incd", "dec", "decd", "tst", "inv", "adc", "sbc", "dadc", NULL
+};
+static const char *const status_ops[] = {
+    "clrc", "setc", "clrz", "setz", "clrn", "setn", "dint", "eint", "nop", NULL
+};
+
+// Cycles for one instruction, or 0 if it isn't in the table
+static unsigned int instruction_cycles(char *mnemonic, char **ops, int op_count) {
+    char *dot = strchr(mnemonic, '.');
+    if (dot) *dot = '\0';                    // .w / .b / .a only change the operand size
+
+    size_t length = strlen(mnemonic);
+    int extended = 0;
+    if (length > 1 && mnemonic[length - 1] == 'x') {
+        mnemonic[length - 1] = '\0';
+        if (in_list(mnemonic, format_one_ops) || in_list(mnemonic, format_two_ops)) {
+            extended = 1;                    // MSP430X form: one more cycle for memory operands
+        } else {
+            mnemonic[length - 1] = 'x';
+        }
+    }
+
+    unsigned int cycles = 0;
+    if (in_list(mnemonic, format_one_ops) && op_count == 2) {
+        cycles = format_one(mnemonic, operand_mode(ops[0]), ops[1]);
+        if (extended && (is_memory(operand_mode(ops[0])) || is_memory(operand_mode(ops[1])))) cycles++;
+    } else if (in_list(mnemonic, format_two_ops) && op_count == 1) {
+        cycles = format_two(mnemonic, operand_mode(ops[0]));
+        if (extended && is_memory(operand_mode(ops[0]))) cycles++;
+    } else if (in_list(mnemonic, jump_ops)) {
+        cycles = 2;
+    } else if (in_list(mnemonic, cgen_ops) && op_count == 1) {
+        cycles = format_one(!strcmp(mnemonic, "clr") ? "mov" : !strcmp(mnemonic, "tst") ? "cmp" : mnemonic,
+                            CGEN, ops[0]);
+    } else if ((!strcmp(mnemonic, "rla") || !strcmp(mnemonic, "rlc")) && op_count == 1) {
+        cycles = format_one(mnemonic, operand_mode(ops[0]), ops[0]);   // add dst, dst
+    } else if (in_list(mnemonic, status_ops)) {
+        cycles = 1;
+    } else if (!strcmp(mnemonic, "pop") && op_count == 1) {
+        cycles = format_one("mov", INC, ops[0]);                       // mov @sp+, dst
+    } else if ((!strcmp(mnemonic, "br") || !strcmp(mnemonic, "bra")) && op_count == 1) {
+        cycles = format_one("mov", operand_mode(ops[0]), "pc");
+    } else if (!strcmp(mnemonic, "ret") || !strcmp(mnemonic, "reta")) {
+        cycles = 4;
+    } else if (!strcmp(mnemonic, "reti")) {
+        cycles = 5;
+    } else if (!strcmp(mnemonic, "calla")) {
+        cycles = 5;
+    } else if ((!strcmp(mnemonic, "pushm") || !strcmp(mnemonic, "popm")) && op_count == 2) {
+        cycles = 2 + (unsigned int)strtol(ops[0] + 1, NULL, 0);
+    } else if ((!strcmp(mnemonic, "rram") || !strcmp(mnemonic, "rrcm") || !strcmp(mnemonic, "rlam") ||
+                !strcmp(mnemonic, "rrum")) && op_count == 2) {
+        cycles = (unsigned int)strtol(ops[0] + 1, NULL, 0);
+    } else if ((!strcmp(mnemonic, "mova") || !strcmp(mnemonic, "adda") || !strcmp(mnemonic, "suba") ||
+                !strcmp(mnemonic, "cmpa")) && op_count == 2) {
+        enum mode src = operand_mode(ops[0]);
+        cycles = (src == REG || src == CGEN) && !is_memory(operand_mode(ops[1])) ? 1 : 3;
+    }
+    return cycles;
+}
+
+static char *trim(char *text) {
+    char *end;
+    while (isspace((unsigned char)*text)) text++;
+    end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) *--end = '\0';
+    return text;
+}
+
+static void print_function(const struct function *f, int *first) {
+    if (f->name[0] == '\0') return;
+    printf("%s\n    {\"name\": \"%s\", \"bytes\": %lu, \"instructions\": %lu, \"cycles\": %lu, \"unknown\": %lu}",
+           *first ? "" : ",", f->name, f->bytes, f->instructions, f->cycles, f->unknown);
+    *first = 0;
+}
+
+int main(int argc, char **argv) {
+    char line[MAX_LINE];
+    struct function current;
+    int first = 1;
+
+    memset(&current, 0, sizeof(current));
+    printf("{\"file\": \"%s\", \"functions\": [", argc > 1 ? argv[1] : "");
+
+    while (fgets(line, sizeof(line), stdin)) {
+        char name[MAX_NAME];
+        unsigned long address;
+
+        // Function label: "00000000 <clkInit>:"
+        if (sscanf(line, "%lx <%127[^>]>:", &address, name) == 2) {
+            print_function(&current, &first);
+            memset(&current, 0, sizeof(current));
+            strcpy(current.name, name);
+            continue;
+        }
+
+        // Instruction: "   4:\t60 01 \tmov\t#6,\t&0x0162\t;..." (long encodings continue
+        // on lines that only hold bytes)
+        char *colon = strchr(line, ':');
+        if (!colon || current.name[0] == '\0' || line[0] != ' ') continue;
+        char *fields[4] = { NULL, NULL, NULL, NULL };
+        int field_count = 0;
+        char *cursor = colon + 1;
+        char *comment = strchr(cursor, ';');
+        if (comment) *comment = '\0';
+        while (field_count < 4) {
+            char *tab = strchr(cursor, '\t');
+            if (!tab) break;
+            *tab = '\0';
+            if (field_count > 0) fields[field_count - 1] = cursor;
+            field_count++;
+            cursor = tab + 1;
+        }
+        if (field_count > 0 && field_count <= 4) fields[field_count - 1] = cursor;
+
+        if (!fields[0]) continue;
+        char *byte = fields[0];
+        while (*byte) {
+            if (isxdigit((unsigned char)byte[0]) && isxdigit((unsigned char)byte[1])) {
+                current.bytes++;
+                byte += 2;
+            } else {
+                byte++;
+            }
+        }
+
+        if (!fields[1] || *trim(fields[1]) == '\0') continue;   // Continuation of the previous instruction
+
+        char mnemonic[32];
+        strncpy(mnemonic, trim(fields[1]), sizeof(mnemonic) - 1);
+        mnemonic[sizeof(mnemonic) - 1] = '\0';
+
+        // Operands are separated by commas (objdump puts a tab after each comma)
+        char *ops[3];
+        int op_count = 0;
+        char operand_text[MAX_LINE] = "";
+        if (fields[2]) {
+            strncpy(operand_text, fields[2], sizeof(operand_text) - 1);
+            if (fields[3]) {
+                strncat(operand_text, fields[3], sizeof(operand_text) - strlen(operand_text) - 1);
+            }
+        }
+        char *operand = strtok(operand_text, ",");
+        while (operand && op_count < 3) {
+            operand = trim(operand);
+            if (*operand) ops[op_count++] = operand;
+            operand = strtok(NULL, ",");
+        }
+
+        unsigned int cycles = instruction_cycles(mnemonic, ops, op_count);
+        if (cycles == 0) {
+            cycles = 2;
+            current.unknown++;
+        }
+        current.instructions++;
+        current.cycles += cycles;
+    }
+
+    print_function(&current, &first);
+    printf("\n]}\n");
+    return 0;
+}
@@ -0,0 +1,2 @@
+// Host stand-in for <msp430.h>: this tree only targets the MSP430FR5739
+#include "msp430fr5739.h"
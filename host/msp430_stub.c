@@ -0,0 +1,131 @@
+// Register storage and intrinsics for the host stand-in device header
+
+#include <string.h>
+#include "msp430fr5739.h"
+
+#define HOST_DEFINE16(name) volatile unsigned int name;
+#define HOST_DEFINE8(name) volatile unsigned char name;
+
+HOST_DEFINE16(WDTCTL)
+HOST_DEFINE16(CSCTL0) HOST_DEFINE8(CSCTL0_H) HOST_DEFINE16(CSCTL1) HOST_DEFINE16(CSCTL2) HOST_DEFINE16(CSCTL3)
+HOST_DEFINE8(P1DIR) HOST_DEFINE8(P1OUT) HOST_DEFINE8(P1SEL0) HOST_DEFINE8(P1SEL1)
+HOST_DEFINE8(P2DIR) HOST_DEFINE8(P2IN) HOST_DEFINE8(P2OUT) HOST_DEFINE8(P2SEL0) HOST_DEFINE8(P2SEL1)
+HOST_DEFINE8(P3DIR) HOST_DEFINE8(P3OUT) HOST_DEFINE8(P3SEL0) HOST_DEFINE8(P3SEL1)
+HOST_DEFINE8(P4DIR) HOST_DEFINE8(P4IN) HOST_DEFINE8(P4OUT) HOST_DEFINE8(P4REN) HOST_DEFINE8(P4SEL0) HOST_DEFINE8(P4SEL1)
+HOST_DEFINE8(P4IES) HOST_DEFINE8(P4IE) HOST_DEFINE8(P4IFG) HOST_DEFINE16(P4IV)
+HOST_DEFINE8(PJDIR) HOST_DEFINE8(PJOUT) HOST_DEFINE8(PJSEL0) HOST_DEFINE8(PJSEL1)
+volatile unsigned int host_eusci_a0[16];
+volatile unsigned int host_eusci_a1[16];
+HOST_DEFINE16(ADC10CTL0) HOST_DEFINE16(ADC10CTL1) HOST_DEFINE16(ADC10CTL2) HOST_DEFINE16(ADC10MCTL0)
+HOST_DEFINE16(ADC10MEM0) HOST_DEFINE16(ADC10IE) HOST_DEFINE16(ADC10IFG) HOST_DEFINE16(ADC10IV)
+HOST_DEFINE16(TA0CTL) HOST_DEFINE16(TA0CCTL0) HOST_DEFINE16(TA0CCTL1) HOST_DEFINE16(TA0CCTL2)
+HOST_DEFINE16(TA0R) HOST_DEFINE16(TA0CCR0) HOST_DEFINE16(TA0CCR1) HOST_DEFINE16(TA0CCR2) HOST_DEFINE16(TA0EX0) HOST_DEFINE16(TA0IV)
+HOST_DEFINE16(TA1CTL) HOST_DEFINE16(TA1CCTL0) HOST_DEFINE16(TA1CCTL1) HOST_DEFINE16(TA1CCTL2)
+HOST_DEFINE16(TA1R) HOST_DEFINE16(TA1CCR0) HOST_DEFINE16(TA1CCR1) HOST_DEFINE16(TA1CCR2) HOST_DEFINE16(TA1EX0) HOST_DEFINE16(TA1IV)
+HOST_DEFINE16(TB1CTL) HOST_DEFINE16(TB1CCTL0) HOST_DEFINE16(TB1CCTL1) HOST_DEFINE16(TB1CCTL2)
+HOST_DEFINE16(TB1R) HOST_DEFINE16(TB1CCR0) HOST_DEFINE16(TB1CCR1) HOST_DEFINE16(TB1CCR2) HOST_DEFINE16(TB1EX0) HOST_DEFINE16(TB1IV)
+
+#define TXBUF_INDEX 7            // UCAxTXBUF is at byte offset 0x0E
+#define TXBUF_EMPTY 0xFFFF       // No byte waiting to be logged
+#define RXBUF_INDEX 6
+#define IE_INDEX 13
+#define IFG_INDEX 14
+#define IV_INDEX 15
+
+volatile unsigned int host_sr = 0;
+unsigned long host_delay_cycles = 0;
+unsigned char host_tx_log[2][HOST_TX_LOG_SIZE];
+unsigned long host_tx_count[2];
+
+static volatile unsigned int *eusci_block(unsigned char port) {
+    return port ? host_eusci_a1 : host_eusci_a0;
+}
+
+void __bis_SR_register(unsigned int bits) {
+    host_sr |= bits;
+}
+
+void __bic_SR_register_on_exit(unsigned int bits) {
+    host_sr &= ~bits;
+}
+
+void __disable_interrupt(void) {
+    host_sr &= ~GIE;
+}
+
+void __enable_interrupt(void) {
+    host_sr |= GIE;
+}
+
+unsigned short __get_interrupt_state(void) {
+    return host_sr & GIE;
+}
+
+void __set_interrupt_state(unsigned short state) {
+    host_sr = (host_sr & ~GIE) | (state & GIE);
+}
+
+void __no_operation(void) {
+}
+
+void __delay_cycles(unsigned long cycles) {
+    host_delay_cycles += cycles;
+}
+
+void host_uart_flush(unsigned char port) {
+    volatile unsigned int *txbuf = &eusci_block(port)[TXBUF_INDEX];
+    if (*txbuf != TXBUF_EMPTY) {
+        host_tx_log[port][host_tx_count[port] % HOST_TX_LOG_SIZE] = (unsigned char)*txbuf;
+        host_tx_count[port]++;
+        *txbuf = TXBUF_EMPTY;
+        eusci_block(port)[IFG_INDEX] |= UCTXIFG;   // The byte moved on, TXBUF is free again
+    }
+}
+
+void host_uart_receive(unsigned char port, unsigned char data) {
+    eusci_block(port)[RXBUF_INDEX] = data;
+    eusci_block(port)[IFG_INDEX] |= UCRXIFG;
+}
+
+unsigned int host_uart_vector(unsigned char port) {
+    volatile unsigned int *block = eusci_block(port);
+    unsigned int pending;
+
+    host_uart_flush(port);
+    pending = block[IFG_INDEX] & block[IE_INDEX];
+    if (pending & UCRXIFG) {                       // RX has the higher priority
+        block[IFG_INDEX] &= ~UCRXIFG;
+        block[IV_INDEX] = USCI_UART_UCRXIFG;
+    } else if (pending & UCTXIFG) {
+        block[IFG_INDEX] &= ~UCTXIFG;              // Like the hardware, the IV read clears TXIFG
+        block[IV_INDEX] = USCI_UART_UCTXIFG;
+    } else {
+        block[IV_INDEX] = 0;
+    }
+    return block[IV_INDEX];
+}
+
+// Called on every UCAxTXBUF access: log the previous write, then hand out the slot
+volatile unsigned int *host_txbuf(unsigned char port) {
+    host_uart_flush(port);
+    return &eusci_block(port)[TXBUF_INDEX];
+}
+
+void host_reset(void) {
+    unsigned char port;
+    for (port = 0; port < 2; port++) {
+        volatile unsigned int *block = eusci_block(port);
+        unsigned char i;
+        for (i = 0; i < 16; i++) block[i] = 0;
+        block[TXBUF_INDEX] = TXBUF_EMPTY;
+        block[IFG_INDEX] = UCTXIFG;     // Transmitter idle, so polling loops fall through
+        host_tx_count[port] = 0;
+    }
+    memset(host_tx_log, 0, sizeof(host_tx_log));
+    host_sr = 0;
+    host_delay_cycles = 0;
+    TA0R = TA1R = TB1R = 0;
+    P4IN = P4IES = P4IFG = 0;
+    P2IN = 0xFF;                 // UART lines idle high
+    PJOUT = P3OUT = 0;
+}
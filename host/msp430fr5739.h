@@ -0,0 +1,220 @@
+// Host stand-in for the TI MSP430FR5739 device header.
+//
+// Lets the firmware sources compile with the host gcc so the benchmarks and
+// tests under bench/ and test/ can call their functions and ISRs directly.
+// Registers are plain memory, bit values match the TI header and the
+// intrinsics only track the status register. Apart from the eUSCI_A flag
+// handling below, nothing here models the peripherals themselves: a test sets
+// the flags (e.g. UCTXIFG) that the code under test polls.
+
+#ifndef HOST_MSP430FR5739_H
+#define HOST_MSP430FR5739_H
+
+#define HOST_REG16(name) extern volatile unsigned int name;
+#define HOST_REG8(name) extern volatile unsigned char name;
+
+// Watchdog and clock system
+HOST_REG16(WDTCTL)
+HOST_REG16(CSCTL0) HOST_REG8(CSCTL0_H) HOST_REG16(CSCTL1) HOST_REG16(CSCTL2) HOST_REG16(CSCTL3)
+
+// Digital I/O
+HOST_REG8(P1DIR) HOST_REG8(P1OUT) HOST_REG8(P1SEL0) HOST_REG8(P1SEL1)
+HOST_REG8(P2DIR) HOST_REG8(P2IN) HOST_REG8(P2OUT) HOST_REG8(P2SEL0) HOST_REG8(P2SEL1)
+HOST_REG8(P3DIR) HOST_REG8(P3OUT) HOST_REG8(P3SEL0) HOST_REG8(P3SEL1)
+HOST_REG8(P4DIR) HOST_REG8(P4IN) HOST_REG8(P4OUT) HOST_REG8(P4REN) HOST_REG8(P4SEL0) HOST_REG8(P4SEL1)
+HOST_REG8(P4IES) HOST_REG8(P4IE) HOST_REG8(P4IFG) HOST_REG16(P4IV)
+HOST_REG8(PJDIR) HOST_REG8(PJOUT) HOST_REG8(PJSEL0) HOST_REG8(PJSEL1)
+
+// eUSCI_A0/A1 keep the device register layout (word index = byte offset / 2)
+// so code that addresses a port through &UCAxCTLW0 plus an offset works
+extern volatile unsigned int host_eusci_a0[16];
+extern volatile unsigned int host_eusci_a1[16];
+#define UCA0CTLW0 host_eusci_a0[0]
+#define UCA0BRW host_eusci_a0[3]
+#define UCA0MCTLW host_eusci_a0[4]
+#define UCA0STATW host_eusci_a0[5]
+#define UCA0RXBUF host_eusci_a0[6]
+#define UCA0TXBUF (*host_txbuf(0))
+#define UCA0IE host_eusci_a0[13]
+#define UCA0IFG host_eusci_a0[14]
+#define UCA0IV host_eusci_a0[15]
+#define UCA1CTLW0 host_eusci_a1[0]
+#define UCA1BRW host_eusci_a1[3]
+#define UCA1MCTLW host_eusci_a1[4]
+#define UCA1STATW host_eusci_a1[5]
+#define UCA1RXBUF host_eusci_a1[6]
+#define UCA1TXBUF (*host_txbuf(1))
+#define UCA1IE host_eusci_a1[13]
+#define UCA1IFG host_eusci_a1[14]
+#define UCA1IV host_eusci_a1[15]
+
+// ADC10_B
+HOST_REG16(ADC10CTL0) HOST_REG16(ADC10CTL1) HOST_REG16(ADC10CTL2) HOST_REG16(ADC10MCTL0)
+HOST_REG16(ADC10MEM0) HOST_REG16(ADC10IE) HOST_REG16(ADC10IFG) HOST_REG16(ADC10IV)
+
+// Timer_A0, Timer_A1, Timer_B1
+HOST_REG16(TA0CTL) HOST_REG16(TA0CCTL0) HOST_REG16(TA0CCTL1) HOST_REG16(TA0CCTL2)
+HOST_REG16(TA0R) HOST_REG16(TA0CCR0) HOST_REG16(TA0CCR1) HOST_REG16(TA0CCR2) HOST_REG16(TA0EX0) HOST_REG16(TA0IV)
+HOST_REG16(TA1CTL) HOST_REG16(TA1CCTL0) HOST_REG16(TA1CCTL1) HOST_REG16(TA1CCTL2)
+HOST_REG16(TA1R) HOST_REG16(TA1CCR0) HOST_REG16(TA1CCR1) HOST_REG16(TA1CCR2) HOST_REG16(TA1EX0) HOST_REG16(TA1IV)
+HOST_REG16(TB1CTL) HOST_REG16(TB1CCTL0) HOST_REG16(TB1CCTL1) HOST_REG16(TB1CCTL2)
+HOST_REG16(TB1R) HOST_REG16(TB1CCR0) HOST_REG16(TB1CCR1) HOST_REG16(TB1CCR2) HOST_REG16(TB1EX0) HOST_REG16(TB1IV)
+
+#define BIT0 0x0001
+#define BIT1 0x0002
+#define BIT2 0x0004
+#define BIT3 0x0008
+#define BIT4 0x0010
+#define BIT5 0x0020
+#define BIT6 0x0040
+#define BIT7 0x0080
+
+// Status register
+#define GIE 0x0008
+#define CPUOFF 0x0010
+#define OSCOFF 0x0020
+#define SCG0 0x0040
+#define SCG1 0x0080
+#define LPM0_bits (CPUOFF)
+#define LPM3_bits (SCG1 | SCG0 | CPUOFF)
+#define LPM4_bits (SCG1 | SCG0 | OSCOFF | CPUOFF)
+
+// Watchdog
+#define WDTPW 0x5A00
+#define WDTHOLD 0x0080
+
+// Clock system
+#define CSKEY 0xA500
+#define DCORSEL 0x0080
+#define DCOFSEL_0 0x0000
+#define DCOFSEL_3 0x0006
+#define SELM__DCOCLK 0x0003
+#define SELS__DCOCLK 0x0030
+#define SELA__DCOCLK 0x0300
+#define DIVM__1 0x0000
+#define DIVM__2 0x0001
+#define DIVM__4 0x0002
+#define DIVM__8 0x0003
+#define DIVS__1 0x0000
+#define DIVS__2 0x0010
+#define DIVS__4 0x0020
+#define DIVS__8 0x0030
+#define DIVA__1 0x0000
+#define DIVA__8 0x0300
+
+// eUSCI_A UART
+#define UCSWRST 0x0001
+#define UCSSEL__SMCLK 0x0080
+#define UCOS16 0x0001
+#define UCBUSY 0x0001
+#define UCOE 0x0020
+#define UCFE 0x0040
+#define UCRXIE 0x0001
+#define UCTXIE 0x0002
+#define UCRXIFG 0x0001
+#define UCTXIFG 0x0002
+#define USCI_NONE 0x0000
+#define USCI_UART_UCRXIFG 0x0002
+#define USCI_UART_UCTXIFG 0x0004
+
+// ADC10_B
+#define ADC10SC 0x0001
+#define ADC10ENC 0x0002
+#define ADC10ON 0x0010
+#define ADC10MSC 0x0080
+#define ADC10SHT_2 0x0200
+#define ADC10BUSY 0x0001
+#define ADC10CONSEQ_0 0x0000
+#define ADC10CONSEQ_2 0x0004
+#define ADC10SSEL_3 0x0018
+#define ADC10SHP 0x0200
+#define ADC10SHS_0 0x0000
+#define ADC10SHS_1 0x0400
+#define ADC10RES 0x0010
+#define ADC10INCH_1 0x0001
+#define ADC10INCH_4 0x0004
+#define ADC10INCH_12 0x000C
+#define ADC10INCH_13 0x000D
+#define ADC10INCH_14 0x000E
+#define ADC10IE0 0x0001
+#define ADC10IFG0 0x0001
+#define ADC10IV_ADC10IFG 0x000C
+
+// Timer_A / Timer_B
+#define TAIFG 0x0001
+#define TAIE 0x0002
+#define TACLR 0x0004
+#define TBCLR 0x0004
+#define MC_0 0x0000
+#define MC_1 0x0010
+#define MC_2 0x0020
+#define ID__1 0x0000
+#define ID__2 0x0040
+#define ID__4 0x0080
+#define ID__8 0x00C0
+#define TASSEL_1 0x0100
+#define TASSEL_2 0x0200
+#define TBSSEL_2 0x0200
+#define TAIDEX_0 0x0000
+#define TAIDEX_7 0x0007
+#define TBIDEX_0 0x0000
+#define CCIFG 0x0001
+#define COV 0x0002
+#define CCI 0x0008
+#define CCIE 0x0010
+#define OUTMOD_3 0x0060
+#define OUTMOD_7 0x00E0
+#define CAP 0x0100
+#define CLLD_1 0x0200
+#define SCS 0x0800
+#define CCIS_0 0x0000
+#define CM_1 0x4000
+#define CM_2 0x8000
+#define CM_3 0xC000
+#define TA0IV_TAIFG 0x000E
+#define TA1IV_TACCR1 0x0002
+#define TA1IV_TACCR2 0x0004
+#define P4IV_P4IFG0 0x0002
+#define P4IV_P4IFG1 0x0004
+
+// Interrupt vectors (values only need to be distinct here)
+#define USCI_A0_VECTOR 1
+#define USCI_A1_VECTOR 2
+#define TIMER0_A0_VECTOR 3
+#define TIMER0_A1_VECTOR 4
+#define TIMER1_A0_VECTOR 5
+#define TIMER1_A1_VECTOR 6
+#define TIMER1_B0_VECTOR 7
+#define ADC10_VECTOR 8
+#define PORT4_VECTOR 9
+
+// Compiler intrinsics
+#define __interrupt
+#define __even_in_range(value, limit) (value)
+extern volatile unsigned int host_sr;          // Simulated status register
+extern unsigned long host_delay_cycles;        // Total cycles requested through __delay_cycles
+void __bis_SR_register(unsigned int bits);
+void __bic_SR_register_on_exit(unsigned int bits);
+void __disable_interrupt(void);
+void __enable_interrupt(void);
+unsigned short __get_interrupt_state(void);
+void __set_interrupt_state(unsigned short state);
+void __no_operation(void);
+void __delay_cycles(unsigned long cycles);
+
+// Host helpers. Each write to UCAxTXBUF is appended to host_tx_log[x]
+// (the log wraps after HOST_TX_LOG_SIZE bytes, host_tx_count keeps counting)
+#define HOST_TX_LOG_SIZE 4096
+extern unsigned char host_tx_log[2][HOST_TX_LOG_SIZE];
+extern unsigned long host_tx_count[2];
+volatile unsigned int *host_txbuf(unsigned char port);
+void host_uart_flush(unsigned char port);       // Log a byte written through &UCAxCTLW0 + offset, set UCTXIFG
+void host_uart_receive(unsigned char port, unsigned char data); // Put a byte in UCAxRXBUF and set UCRXIFG
+// Interrupt controller plus UCAxIV read: flush UCAxTXBUF, then take the highest
+// priority flag that is both set and enabled, clear it and load UCAxIV with its
+// vector value. Returns 0 when no interrupt is pending, so a test dispatches
+// with while (host_uart_vector(0)) uart_ISR();
+unsigned int host_uart_vector(unsigned char port);
+void host_reset(void);                          // Clear every register, UCTXIFG set on both ports
+
+#endif
@@ -0,0 +1,2 @@
+// Host stand-in for the FR57xx generic header: everything used lives in msp430fr5739.h
+#include "msp430fr5739.h"
@@ -1,5 +1,43 @@
 #include <msp430.h>
 
+// 1 = decode P4.0/P4.1 as a quadrature encoder, 0 = two buttons toggling LED7/LED8
+#define QUADRATURE_MODE 1
+
+// Edge timestamps come from Timer A0 at SMCLK / 8
+#define EDGE_TIMER_HZ 125000UL
+
+// Velocity is reported every REPORT_CYCLES MCLK cycles (0.1 s at 8 MHz)
+#define MCLK_HZ 8000000UL
+#define REPORT_CYCLES 800000UL
+
+// An edge interval is only timed if the previous edge came in this report window
+// or the one before, so the 16-bit timer must not wrap within two windows
+#if 2 * REPORT_CYCLES * EDGE_TIMER_HZ / MCLK_HZ > 65535
+#error "Two report windows are longer than one Timer A0 wrap"
+#endif
+
+#if QUADRATURE_MODE
+// Position change for each transition, indexed by (previous state << 2) | new state,
+// where state = P4.1:P4.0. Forward is 00 -> 01 -> 11 -> 10 -> 00
+const signed char quadrature_table[16] = {
+     0, +1, -1,  0,
+    -1,  0,  0, +1,
+    +1,  0,  0, -1,
+     0, -1, +1,  0,
+};
+
+// Quadrature decoder variables
+volatile long position = 0;                 // Encoder position in counts (4 per cycle)
+volatile unsigned int quadrature_errors = 0; // Illegal transitions (both pins changed at once)
+unsigned char quadrature_state = 0;         // Last decoded P4.1:P4.0 state
+unsigned int last_edge_time = 0;            // TA0R at the last counted edge
+volatile unsigned int edge_interval = 0;    // TA0 ticks between the last two counted edges
+volatile signed char edge_direction = 0;    // Direction of the last counted edge
+volatile unsigned char edge_seen = 0;       // Set by the ISR on every counted edge
+volatile unsigned char edge_stale = 1;      // No edge in the last report window, so last_edge_time may have wrapped
+long velocity = 0;                          // Counts per second, updated by main
+#endif
+
 void configure_clocks() {
     CSCTL0 = 0xA500;                  // Write password to modify CS registers
     CSCTL1 = DCOFSEL_3;               // Set DCO to 8 MHz
@@ -67,23 +105,125 @@ void configure_pins_for_interrupt() {
     P3OUT &= ~(BIT6 | BIT7);   // Initialize LEDs as off (set P3.6 and P3.7 low)
 }
 
+#if QUADRATURE_MODE
+void configure_quadrature_decoder() {
+    // Set P4.0 and P4.1 as GPIO inputs with pull-ups, as in button mode
+    P4DIR &= ~(BIT0 | BIT1);
+    P4SEL1 &= ~(BIT0 | BIT1);
+    P4SEL0 &= ~(BIT0 | BIT1);
+    P4REN |= (BIT0 | BIT1);
+    P4OUT |= (BIT0 | BIT1);
+
+    // Wait for the opposite of each pin's current level, so both edges interrupt
+    quadrature_state = P4IN & (BIT0 | BIT1);
+    P4IES = (P4IES & ~(BIT0 | BIT1)) | quadrature_state; // High pin: falling edge next (IES = 1)
+    P4IFG &= ~(BIT0 | BIT1);   // Changing P4IES can set the flags, so clear them after
+    P4IE |= (BIT0 | BIT1);     // Enable interrupt for P4.0 and P4.1
+
+    // Free-running Timer A0 for edge timestamps
+    TA0CTL = TASSEL_2 | ID__8 | MC_2 | TACLR;  // SMCLK / 8, continuous mode, clear timer
+}
+
+// LEDs 1-4 and 6-8 show the position. P3.4 (LED5) keeps the SMCLK output from configure_clocks()
+void configure_position_leds() {
+    PJDIR |= (BIT0 | BIT1 | BIT2 | BIT3);      // PJ.0 to PJ.3 as GPIO outputs
+    PJSEL1 &= ~(BIT0 | BIT1 | BIT2 | BIT3);
+    PJSEL0 &= ~(BIT0 | BIT1 | BIT2 | BIT3);
+
+    P3DIR |= (BIT5 | BIT6 | BIT7);             // P3.5 to P3.7 as GPIO outputs
+    P3SEL1 &= ~(BIT5 | BIT6 | BIT7);
+    P3SEL0 &= ~(BIT5 | BIT6 | BIT7);
+}
+
+// Velocity from the interval between the last two edges. Called every 0.1 s from main,
+// so with no edge since the previous call the encoder is reported as stopped
+void update_velocity() {
+    __disable_interrupt();            // Interval and direction must come from the same edge
+    unsigned int interval = edge_interval;
+    signed char direction = edge_direction;
+    unsigned char seen = edge_seen;
+    edge_seen = 0;
+    if (!seen) edge_stale = 1;        // The next edge can't be timed against the last one
+    __enable_interrupt();
+
+    if (seen && interval != 0) {
+        velocity = direction * (long)(EDGE_TIMER_HZ / interval);
+    } else {
+        velocity = 0;
+    }
+}
+
+// Show the low 7 bits of the position on LEDs 1-4 and 6-8
+void show_position() {
+    __disable_interrupt();            // Read the 32-bit position in one piece
+    unsigned char low_byte = position & 0x7F;
+    __enable_interrupt();
+
+    PJOUT = (PJOUT & ~(BIT0 | BIT1 | BIT2 | BIT3)) | (low_byte & 0x0F);  // LEDs 1-4: bits 0-3
+    P3OUT = (P3OUT & ~(BIT5 | BIT6 | BIT7)) | ((low_byte << 1) & 0xE0);  // LEDs 6-8: bits 4-6
+}
+#endif
+
 int main(void) {
     WDTCTL = WDTPW | WDTHOLD;           // Stop watchdog timer
 
 
     configure_clocks();
 
+#if QUADRATURE_MODE
+    configure_position_leds();          // LEDs show the position
+    configure_quadrature_decoder();     // Decode the encoder on P4.0/P4.1
+#endif
 
     __bis_SR_register(GIE);             // Enable global interrupts
 
     while (1) {
-        __delay_cycles(800000);  // Simple delay (~0.1 second at 8 MHz)
+        __delay_cycles(REPORT_CYCLES);  // Simple delay (~0.1 second at 8 MHz)
+#if QUADRATURE_MODE
+        update_velocity();
+        show_position();
+#endif
     }
 
 }
 
 
 
+#if QUADRATURE_MODE
+// Port 4 interrupt service routine (ISR): decode one quadrature transition
+#pragma vector = PORT4_VECTOR
+__interrupt void Port_4_ISR(void) {
+    unsigned int now = TA0R;    // Edge timestamp
+    unsigned char state;
+
+    // Re-arm both pins for the opposite edge. If a pin changes again while this
+    // runs, go round once more so that edge is decoded too
+    do {
+        state = P4IN & (BIT0 | BIT1);
+        P4IES = (P4IES & ~(BIT0 | BIT1)) | state; // High pin: falling edge next, low pin: rising
+        P4IFG &= ~(BIT0 | BIT1);                  // Clear flags, including any set by the P4IES write
+
+        if ((quadrature_state ^ state) == (BIT0 | BIT1)) {
+            quadrature_errors++;                  // Both pins changed: an edge was missed
+        } else {
+            signed char step = quadrature_table[(quadrature_state << 2) | state];
+            if (step != 0) {
+                position += step;
+                if (edge_stale) {
+                    edge_interval = 0;            // Previous edge too old to time: reads as stopped
+                    edge_stale = 0;
+                } else {
+                    edge_interval = now - last_edge_time;
+                }
+                edge_direction = step;
+                edge_seen = 1;
+                last_edge_time = now;
+            }
+        }
+        quadrature_state = state;
+    } while ((P4IN & (BIT0 | BIT1)) != state);
+}
+#else
 // Port 4 interrupt service routine (ISR)
 #pragma vector = PORT4_VECTOR
 __interrupt void Port_4_ISR(void) {
@@ -96,6 +236,4 @@ __interrupt void Port_4_ISR(void) {
         P3OUT ^= BIT7;          // Toggle LED8 (P3.7)
     }
 }
-
-
-
+#endif
@@ -0,0 +1,136 @@
+// Checks the SetADCAccelerometerChannels.c ADC ISR and UART stream: the X, Y, Z
+// channel rotation between triggers, that each sample is stamped with the time
+// of its Z trigger, and that the PC can rebuild those timestamps from the stream
+// through rate changes and lost samples
+
+#define main firmware_main
+#include "SetADCAccelerometerChannels.c"
+#undef main
+
+#include <stdio.h>
+
+#define SAMPLES 400
+#define CONVERSIONS (SAMPLES * TRIGGERS_PER_SAMPLE)
+#define ISR_DELAY 40                 // SMCLK ticks from the trigger to the ADC ISR
+
+static const unsigned int channels[TRIGGERS_PER_SAMPLE] = { ADC_X_CHANNEL, ADC_Y_CHANNEL, ADC_Z_CHANNEL };
+static const unsigned int results[TRIGGERS_PER_SAMPLE] = { 400, 600, 800 }; // 100, 150 and 200 on the wire
+
+static unsigned long tx_read;
+static unsigned long pushed_times[SAMPLES];
+static unsigned int pushed;
+
+static int next_byte(void) {
+    host_uart_flush(0);
+    if (tx_read == host_tx_count[0]) return -1;
+    return host_tx_log[0][tx_read++ % HOST_TX_LOG_SIZE];
+}
+
+// One conversion of axis i % 3: the channel it was taken on, TA0R when the ISR
+// runs, the channel and ENC the ISR leaves for the next trigger, and the time of
+// that trigger worked out from the CCR0 the ISR leaves
+static unsigned long convert(unsigned long trigger_time, unsigned int i, unsigned int delay) {
+    unsigned int axis = i % TRIGGERS_PER_SAMPLE;
+    unsigned char head = fifo_head;
+    unsigned int elapsed = delay >> TIMER_SHIFT;
+
+    if (ADC10MCTL0 != channels[axis] || !(ADC10CTL0 & ADC10ENC)) {
+        fprintf(stderr, "FAIL: conversion %u armed on channel %u, ENC %u\n", i, ADC10MCTL0, !!(ADC10CTL0 & ADC10ENC));
+        return 0;
+    }
+
+    ADC10MEM0 = axis == 2 && i / TRIGGERS_PER_SAMPLE == 3 ? 1023 : results[axis]; // One saturated Z
+    TA0R = elapsed - 1;
+    ADC10_ISR();
+
+    if (fifo_head != head) {
+        if (axis != 2) {
+            fprintf(stderr, "FAIL: conversion %u queued a sample before Z\n", i);
+            return 0;
+        }
+        if (sample_fifo[head & FIFO_MASK].timestamp != trigger_time) {
+            fprintf(stderr, "FAIL: sample stamped %lu, Z triggered at %lu\n", sample_fifo[head & FIFO_MASK].timestamp, trigger_time);
+            return 0;
+        }
+        pushed_times[pushed++] = trigger_time;
+    }
+
+    if (TA0CCR0 != TIMER_PERIOD(rate_shift) - 1 || TA0CCR1 != TIMER_PERIOD(rate_shift) / 2 ||
+        (TA0CTL & ID__8) != TIMER_DIVIDER || !(TA0CTL & MC_1)) {
+        fprintf(stderr, "FAIL: TA0CTL %04X, CCR0 %u do not match rate_shift %u\n", TA0CTL, TA0CCR0, rate_shift);
+        return 0;
+    }
+    // The ISR runs after the rollover, so the new CCR0 times the whole period
+    return trigger_time + ((TA0CCR0 + 1UL) << TIMER_SHIFT);
+}
+
+int main(void) {
+    unsigned long trigger_time, time = 0;
+    unsigned int i, samples = 0, statuses = 0, overruns = 0, reductions = 0;
+    unsigned int time_high = 0, rate = 0, max_rate = 0, exact = 0;
+    int byte;
+
+    host_reset();
+    configure_ADC10();
+    configure_timer_trigger();
+    TA0CTL &= ~TACLR;                // The timer clears TACLR itself
+    trigger_time = (unsigned long)TA0CCR0 << TIMER_SHIFT; // First trigger: TA0R counts from 0 to CCR0
+    ADC10IV = ADC10IV_ADC10IFG;
+
+    // Main keeps up, then stalls for samples 100 to 149, then catches up again
+    for (i = 0; i < CONVERSIONS; i++) {
+        unsigned int sample = i / TRIGGERS_PER_SAMPLE;
+
+        trigger_time = convert(trigger_time, i, ISR_DELAY + i % 16);
+        if (trigger_time == 0) return 1;
+        if (sample < 100 || sample >= 150) drain_samples();
+    }
+
+    // Decode: each sample is the previous time plus (3 * SAMPLE_PERIOD) << rate,
+    // unless time and rate status packets came before it
+    while ((byte = next_byte()) >= 0) {
+        if (byte != START_BYTE) {
+            fprintf(stderr, "FAIL: expected a start byte, got %02X\n", byte);
+            return 1;
+        }
+        byte = next_byte();
+        if (byte == START_BYTE) {
+            unsigned char id = next_byte(), upper = next_byte(), lower = next_byte(), escape = next_byte();
+            unsigned int value = ((escape & 0x01) ? 0xFF00 : upper << 8) | ((escape & 0x02) ? 0xFF : lower);
+            if (id == STATUS_TIME_HIGH) time_high = value;
+            if (id == STATUS_TIME_LOW) {
+                time = (unsigned long)time_high << 16 | value;
+                exact = 1;
+            }
+            if (id == STATUS_RATE) {
+                rate = value;
+                if (rate > max_rate) max_rate = rate;
+            }
+            if (id == STATUS_OVERRUNS) overruns = value;
+            if (id == STATUS_REDUCTIONS) reductions = value;
+            statuses++;
+        } else {
+            int y = next_byte(), z = next_byte();
+            if (byte != 100 || y != 150 || (z != 200 && !(samples == 3 && z == DATA_MAX))) {
+                fprintf(stderr, "FAIL: sample %u is X %d, Y %d, Z %d\n", samples, byte, y, z);
+                return 1;
+            }
+            if (!exact) time += (3UL * SAMPLE_PERIOD) << rate;
+            exact = 0;
+            if (samples >= pushed || time != pushed_times[samples]) {
+                fprintf(stderr, "FAIL: sample %u decoded at %lu, taken at %lu\n", samples, time, pushed_times[samples]);
+                return 1;
+            }
+            samples++;
+        }
+    }
+
+    printf("%u samples (%u lost), %u status packets, highest rate shift %u, %u reductions\n",
+           samples, overruns, statuses, max_rate, reductions);
+    if (samples != pushed || fifo_overruns == 0 || overruns != fifo_overruns || reductions != rate_reductions ||
+        max_rate != MAX_RATE_SHIFT || rate_shift != 0) {
+        fprintf(stderr, "FAIL: expected every queued sample and the counters on the wire\n");
+        return 1;
+    }
+    return 0;
+}
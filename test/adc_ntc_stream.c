@@ -0,0 +1,140 @@
+// Checks the ADCNTCExternalConfig.c UART stream: sample packets, the status
+// packets between them, and that the PC can rebuild every sample's timestamp
+// through rate changes and lost samples. Built a second time with
+// SOFTWARE_TRIGGER=1 for the baseline where the CCR0 ISR starts each conversion
+
+#define main firmware_main
+#include "ADCNTCExternalConfig.c"
+#undef main
+
+#include <stdio.h>
+
+#define CONVERSIONS 400
+#define ISR_DELAY 40                 // SMCLK ticks from the trigger to the ADC ISR
+#define START_DELAY 8                // Software trigger: SMCLK ticks from CCR0 to ADC10SC
+
+// Spread of a delay that varies over 16 SMCLK ticks, as the timer measures it
+#define MEASURED_SPREAD(delay) (((((delay) + 15) >> TIMER_SHIFT) - ((delay) >> TIMER_SHIFT)) << TIMER_SHIFT)
+
+#if SOFTWARE_TRIGGER
+#define EXPECTED_SAMPLE_SPREAD MEASURED_SPREAD(START_DELAY)
+#else
+#define EXPECTED_SAMPLE_SPREAD 0     // The timer output starts the conversion
+#endif
+
+static unsigned long tx_read;
+static unsigned long pushed_times[CONVERSIONS];
+static unsigned int pushed;
+
+static int next_byte(void) {
+    host_uart_flush(0);
+    if (tx_read == host_tx_count[0]) return -1;
+    return host_tx_log[0][tx_read++ % HOST_TX_LOG_SIZE];
+}
+
+// The timer side of one conversion: TA0R when the ISRs run, and the time of the
+// next trigger worked out from the CCR0 the ADC ISR leaves
+static unsigned long convert(unsigned long trigger_time, unsigned int value, unsigned int delay, unsigned int start) {
+    unsigned int overruns = fifo_overruns;
+    unsigned int elapsed = delay >> TIMER_SHIFT;
+
+#if SOFTWARE_TRIGGER
+    TA0R = (start >> TIMER_SHIFT) - 1;
+    Timer_A_ISR();
+    if (!(ADC10CTL0 & ADC10SC)) {
+        fprintf(stderr, "FAIL: the CCR0 ISR did not start a conversion\n");
+        return 0;
+    }
+    ADC10CTL0 &= ~ADC10SC;           // The ADC clears ADC10SC once sampling starts
+#else
+    (void)start;
+#endif
+    ADC10MEM0 = value;
+    TA0R = elapsed - 1;
+    ADC10_ISR();
+    if (fifo_overruns == overruns) pushed_times[pushed++] = trigger_time;
+
+    if (TA0CCR0 != TIMER_PERIOD(rate_shift) - 1 || TA0CCR1 != TIMER_PERIOD(rate_shift) / 2 ||
+        (TA0CTL & ID__8) != TIMER_DIVIDER || !(TA0CTL & MC_1)) {
+        fprintf(stderr, "FAIL: TA0CTL %04X, CCR0 %u do not match rate_shift %u\n", TA0CTL, TA0CCR0, rate_shift);
+        return 0;
+    }
+    // The ISR runs after the rollover, so the new CCR0 times the whole period
+    return trigger_time + ((TA0CCR0 + 1UL) << TIMER_SHIFT);
+}
+
+int main(void) {
+    unsigned long trigger_time, time = 0;
+    unsigned int i, samples = 0, statuses = 0, spread = 0, sample_spread = 0xFFFF, overruns = 0, reductions = 0;
+    unsigned int time_high = 0, rate = 0, max_rate = 0, exact = 0;
+    int byte;
+
+    host_reset();
+    configure_ADC10();
+    configure_timer_trigger();
+    TA0CTL &= ~TACLR;                // The timer clears TACLR itself
+    trigger_time = (unsigned long)TA0CCR0 << TIMER_SHIFT; // First trigger: TA0R counts from 0 to CCR0
+    ADC10IV = ADC10IV_ADC10IFG;
+
+    // Main keeps up, then stalls long enough to trigger backpressure and lose
+    // samples, then catches up again. One saturated sample, ISR delays 40 to 55 ticks
+    for (i = 0; i < CONVERSIONS; i++) {
+        trigger_time = convert(trigger_time, i == 3 ? 1023 : 720, ISR_DELAY + i % 16, START_DELAY + i % 16);
+        if (trigger_time == 0) return 1;
+        if (i < 100 || i >= 150) drain_samples();
+        if (TA0CTL & TACLR) {
+            fprintf(stderr, "FAIL: a rate change cleared TA0R\n");
+            return 1;
+        }
+    }
+
+    // Decode: each sample is the previous time plus SAMPLE_PERIOD << rate,
+    // unless time and rate status packets came before it
+    while ((byte = next_byte()) >= 0) {
+        if (byte != START_BYTE) {
+            fprintf(stderr, "FAIL: expected a start byte, got %02X\n", byte);
+            return 1;
+        }
+        byte = next_byte();
+        if (byte == START_BYTE) {
+            unsigned char id = next_byte(), upper = next_byte(), lower = next_byte(), escape = next_byte();
+            unsigned int value = ((escape & 0x01) ? 0xFF00 : upper << 8) | ((escape & 0x02) ? 0xFF : lower);
+            if (id == STATUS_JITTER) spread = value;
+            if (id == STATUS_SAMPLE_JITTER) sample_spread = value;
+            if (id == STATUS_TIME_HIGH) time_high = value;
+            if (id == STATUS_TIME_LOW) {
+                time = (unsigned long)time_high << 16 | value;
+                exact = 1;
+            }
+            if (id == STATUS_RATE) {
+                rate = value;
+                if (rate > max_rate) max_rate = rate;
+            }
+            if (id == STATUS_OVERRUNS) overruns = value;
+            if (id == STATUS_REDUCTIONS) reductions = value;
+            statuses++;
+        } else if (byte > DATA_MAX) {
+            fprintf(stderr, "FAIL: sample byte %02X\n", byte);
+            return 1;
+        } else {
+            if (!exact) time += (unsigned long)SAMPLE_PERIOD << rate;
+            exact = 0;
+            if (samples >= pushed || time != pushed_times[samples]) {
+                fprintf(stderr, "FAIL: sample %u decoded at %lu, taken at %lu\n", samples, time, pushed_times[samples]);
+                return 1;
+            }
+            samples++;
+        }
+    }
+
+    printf("%u samples (%u lost), %u status packets, highest rate shift %u, %u reductions, "
+           "trigger-to-ISR spread %u ticks, sampling instant spread %u ticks\n",
+           samples, overruns, statuses, max_rate, reductions, spread, sample_spread);
+    if (samples != pushed || fifo_overruns == 0 || overruns != fifo_overruns || reductions != rate_reductions ||
+        max_rate != MAX_RATE_SHIFT || rate_shift != 0 || spread != MEASURED_SPREAD(ISR_DELAY) || sample_spread != EXPECTED_SAMPLE_SPREAD) {
+        fprintf(stderr, "FAIL: expected every queued sample, the counters, a spread of %u and a sampling "
+                "spread of %u on the wire\n", MEASURED_SPREAD(ISR_DELAY), EXPECTED_SAMPLE_SPREAD);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+// Checks the ADCScheduler.c schedule builder and its timer-driven playback:
+// every conversion meets its channel's deadline, long hyperperiods are accepted
+// up to MAX_SCHEDULE conversions, gaps longer than one Timer_A0 cycle are
+// played back with the right conversion times, infeasible requests are rejected
+// with the right error, and sample bytes never look like a start byte
+
+#define main firmware_main
+#include "ADCScheduler.c"
+#undef main
+
+#include <stdio.h>
+
+static int failures;
+static unsigned long gap_cycles_seen;
+
+// Every channel's k-th conversion in a hyperperiod must fall in [k * period, (k + 1) * period)
+static int check_deadlines(void) {
+    unsigned long slot = 0, count[CHANNEL_COUNT] = { 0 };
+    unsigned int i;
+    for (i = 0; i < schedule_length; i++) {
+        struct adc_channel *channel = &channels[schedule[i].channel];
+        unsigned long k = count[schedule[i].channel]++;
+        if (slot < k * channel->period || slot >= (k + 1) * channel->period) {
+            fprintf(stderr, "FAIL: channel %u conversion %lu at slot %lu, period %u\n",
+                    schedule[i].channel, k, slot, channel->period);
+            return 1;
+        }
+        slot += schedule[i].gap;
+    }
+    if (slot != hyperperiod) {
+        fprintf(stderr, "FAIL: gaps add up to %lu slots, hyperperiod %lu\n", slot, hyperperiod);
+        return 1;
+    }
+    for (i = 0; i < CHANNEL_COUNT; i++) {
+        if (count[i] != hyperperiod / channels[i].period) {
+            fprintf(stderr, "FAIL: channel %u converts %lu times per hyperperiod\n", i, count[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Play the schedule through the timer and ISRs for two hyperperiods. Each timer
+// cycle ends at TA0R = TA0CCR0, where TA0.1 rises and triggers a conversion if
+// ADC10ENC is set; the ISRs then run early in the next cycle
+static int check_playback(void) {
+    unsigned long time = 0, expected = 0, conversions = 0, gap_cycles = 0;
+    unsigned int entry = 0;
+
+    host_reset();
+    current_entry = 0;
+    configure_ADC10();
+    configure_timer_trigger();
+
+    while (conversions < 2 * (unsigned long)schedule_length) {
+        unsigned long trigger = time + TA0CCR0;
+        time = trigger + 1;
+        TA0R = 20;
+        if (ADC10CTL0 & ADC10ENC) {
+            unsigned long slot_time = (SLOT_PERIOD - 1) + expected * SLOT_PERIOD;
+            if (trigger != slot_time || ADC10MCTL0 != channels[schedule[entry].channel].inch) {
+                fprintf(stderr, "FAIL: conversion %lu of input %u at tick %lu, expected input %u at %lu\n",
+                        conversions, ADC10MCTL0, trigger, channels[schedule[entry].channel].inch, slot_time);
+                return 1;
+            }
+            expected += schedule[entry].gap;
+            if (++entry == schedule_length) entry = 0;
+            conversions++;
+            ADC10MEM0 = 512;
+            ADC10IV = ADC10IV_ADC10IFG;
+            ADC10_ISR();
+        } else if (TA0CCTL0 & CCIE) {
+            gap_cycles++;
+            Gap_Timer_ISR();
+        } else {
+            fprintf(stderr, "FAIL: timer cycle at tick %lu with neither a conversion nor the gap interrupt\n", trigger);
+            return 1;
+        }
+        if (TA0CCR0 >= 65535U || TA0CCR0 < ADC_CONVERSION_TICKS + ADC_ISR_TICKS) {
+            fprintf(stderr, "FAIL: timer cycle of %u ticks\n", TA0CCR0 + 1);
+            return 1;
+        }
+        output_tail = output_head;             // main keeps up
+    }
+    gap_cycles_seen += gap_cycles;
+    printf("  played %lu conversions over %lu ticks, %lu extra cycles for long gaps\n",
+           conversions, time, gap_cycles);
+    return 0;
+}
+
+// Build a schedule with the NTC channel at rate_hz x oversample and check it
+static void check_config(unsigned int rate_hz, unsigned char oversample, unsigned char expected_error) {
+    unsigned char error;
+
+    channels[3].rate_hz = rate_hz;
+    channels[3].oversample = oversample;
+    error = build_schedule();
+    printf("NTC %u Hz x %u: error %u, hyperperiod %lu slots, %u conversions, utilization %u/1000\n",
+           rate_hz, oversample, error, hyperperiod, schedule_length, utilization);
+    if (error != expected_error) {
+        fprintf(stderr, "FAIL: expected error %u\n", expected_error);
+        failures++;
+        return;
+    }
+    if (error != SCHED_OK && schedule_error_channel != 3) {
+        fprintf(stderr, "FAIL: error blamed on channel %u, not the NTC channel\n", schedule_error_channel);
+        failures++;
+        return;
+    }
+    if (error == SCHED_OK && (check_deadlines() || check_playback())) failures++;
+}
+
+// A full-scale average is sent as DATA_MAX, never as the start byte
+static void check_sample_cap(void) {
+    unsigned long sent;
+
+    host_reset();
+    sent = host_tx_count[0];
+    output_fifo[output_head & OUTPUT_MASK].channel = 3;
+    output_fifo[output_head & OUTPUT_MASK].sum = 1023 * channels[3].oversample;
+    output_head++;
+    transmit_samples();
+    host_uart_flush(0);
+    if (host_tx_count[0] != sent + 3 || host_tx_log[0][(sent + 2) % HOST_TX_LOG_SIZE] != DATA_MAX) {
+        fprintf(stderr, "FAIL: full-scale sample sent as %02X\n", host_tx_log[0][(sent + 2) % HOST_TX_LOG_SIZE]);
+        failures++;
+    }
+}
+
+int main(void) {
+    check_config(5, 4, SCHED_OK);              // The default configuration
+    check_config(2, 1, SCHED_OK);              // 500-slot gaps span several timer cycles
+    check_config(3, 4, SCHED_OK);              // Hyperperiod of 830 slots
+    check_config(1, 1, SCHED_OK);              // 1000-slot hyperperiod, 301 conversions
+
+    // Slow logging: every channel at 2 Hz or less leaves gaps of hundreds of
+    // slots, longer than one timer cycle
+    channels[0].rate_hz = channels[1].rate_hz = channels[2].rate_hz = 2;
+    check_config(1, 1, SCHED_OK);
+    if (gap_cycles_seen == 0) {
+        fprintf(stderr, "FAIL: no gap was split across timer cycles\n");
+        failures++;
+    }
+
+    // Accelerometer axes at 7 and 11 Hz make the hyperperiod far too long
+    channels[0].rate_hz = 7;
+    channels[1].rate_hz = 11;
+    check_config(3, 1, SCHED_ERR_LENGTH);
+
+    // Requests that can't be met at all
+    channels[0].rate_hz = channels[1].rate_hz = channels[2].rate_hz = 100;
+    check_config(0, 1, SCHED_ERR_RATE);                      // No rate
+    check_config(5, MAX_OVERSAMPLE + 1, SCHED_ERR_RATE);     // The sum would overflow 16 bits
+    check_config(SLOT_HZ + 1, 1, SCHED_ERR_RATE);            // More conversions than slots
+
+    // Axes at 250 Hz (period 4) and the NTC at 334 Hz (period 2) need 125% of the slots
+    channels[0].rate_hz = channels[1].rate_hz = channels[2].rate_hz = 250;
+    check_config(334, 1, SCHED_ERR_UTILIZATION);
+
+    // Periods 2, 5, 6 and 8 use 99% of the slots, but in rate-monotonic order the
+    // NTC's first conversion is still waiting when its second one is released
+    channels[0].rate_hz = 500;
+    channels[1].rate_hz = 200;
+    channels[2].rate_hz = 143;
+    check_config(125, 1, SCHED_ERR_DEADLINE);
+
+    channels[3].oversample = 4;
+    check_sample_cap();
+    return failures ? 1 : 0;
+}
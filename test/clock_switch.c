@@ -0,0 +1,111 @@
+// Checks that SerialCommunicator.c only switches clocks in a gap between UART
+// frames, still raises the clock under back-to-back traffic, counts frames that
+// start during a switch and reports its switch statistics
+
+#define main firmware_main
+#include "SerialCommunicator.c"
+#undef main
+
+#include <stdio.h>
+
+static int failures;
+
+static void expect(int condition, const char *what) {
+    if (!condition) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// A byte arrives at TA0R = ticks
+static void receive(unsigned char byte, unsigned int ticks) {
+    TA0R = ticks;
+    host_uart_receive(0, byte);
+    while (host_uart_vector(0)) uart_ISR();
+}
+
+int main(void) {
+    host_reset();
+    clkInit();
+    configure_UART();
+    configure_switch_timer();
+    register_clock_handler(retime_UART);
+    register_clock_handler(retime_timer_b);
+
+    // Half a character after the last byte: stay at the current point
+    receive(0x55, 1000);
+    TA0R = 1000 + CHAR_TIME_US / 2;
+    set_clock_point(CLOCK_HIGH);
+    expect(clock_point == CLOCK_NOMINAL && UCA0BRW == 104, "switched half a character after a byte");
+
+    // A byte on the wire or waiting for the ISR also holds the switch
+    TA0R = 1000 + 2 * CHAR_TIME_US;
+    UCA0STATW = UCBUSY;
+    set_clock_point(CLOCK_HIGH);
+    expect(clock_point == CLOCK_NOMINAL, "switched while a byte was being received");
+    UCA0STATW = 0;
+    UCA0IFG |= UCRXIFG;
+    set_clock_point(CLOCK_HIGH);
+    expect(clock_point == CLOCK_NOMINAL, "switched with a byte waiting for the ISR");
+    UCA0IFG &= ~UCRXIFG;
+
+    // Quiet for a character time: switch and re-time the UART
+    set_clock_point(CLOCK_HIGH);
+    expect(clock_point == CLOCK_HIGH && UCA0BRW == 19 && !(UCA0CTLW0 & UCSWRST) && (UCA0IE & UCRXIE),
+           "no switch after a quiet character time");
+    expect(switch_lost_bytes == 0, "lost a byte on a quiet line");
+
+    // The wait scales with SMCLK (3 MHz here), and a start bit during the switch is counted
+    receive(0x55, 20000);
+    TA0R = 20000 + CHAR_TIME_US * 2;
+    set_clock_point(CLOCK_LOW);
+    expect(clock_point == CLOCK_HIGH, "switched before a character time at 3 MHz");
+    TA0R = 20000 + CHAR_TIME_US * 3;
+    P2IN &= ~BIT1;
+    set_clock_point(CLOCK_LOW);
+    expect(clock_point == CLOCK_LOW && UCA0BRW == 104, "no switch after a quiet character time at 3 MHz");
+    expect(switch_lost_bytes == 1, "start bit during the switch not counted");
+
+    // Back-to-back frames at 1 MHz: the line is never quiet for a character, so
+    // the switch has to happen in the stop bit of a byte just received
+    unsigned int t = 30000, i, queried_late = 0;
+    P2IN |= BIT1;
+    head = tail = count = 0;
+    for (i = 0; i < RX_HIGH_WATER + 4 && clock_point == CLOCK_LOW; i++, t += CHAR_TIME_US) {
+        receive(0x00, t);
+        TA0R = t + CHAR_TIME_US - 1;       // Just before the next start bit: too late
+        clock_policy();
+        queried_late += count >= RX_HIGH_WATER && clock_point == CLOCK_LOW;
+        TA0R = t + 10;                     // Right after the ISR, in the stop bit
+        clock_policy();
+    }
+    expect(queried_late > 0, "switched late in a frame");
+    expect(clock_point == CLOCK_HIGH && count == RX_HIGH_WATER && UCA0BRW == 19,
+           "sustained traffic never raised the clock");
+    expect(switch_lost_bytes == 1, "lost a byte switching in a stop bit");
+
+    // Command 0x04 reports the switch statistics
+    static const unsigned char query[3][PACKET_SIZE] = {
+        { START_BYTE, 0x04, 0x00, STAT_LAST_SWITCH, 0x00 },
+        { START_BYTE, 0x04, 0x00, STAT_MAX_SWITCH, 0x00 },
+        { START_BYTE, 0x04, 0x00, STAT_LOST_BYTES, 0x00 },
+    };
+    const unsigned int reported[3] = { last_switch_us, max_switch_us, switch_lost_bytes };
+    head = tail = count = 0;
+    for (i = 0; i < 3; i++) {
+        unsigned long sent = host_tx_count[0];
+        unsigned int j;
+        for (j = 0; j < PACKET_SIZE; j++) receive(query[i][j], t += CHAR_TIME_US);
+        process_packets();
+        while (host_uart_vector(0)) uart_ISR();
+        host_uart_flush(0);
+        expect(host_tx_count[0] == sent + PACKET_SIZE && host_tx_log[0][sent] == START_BYTE &&
+               host_tx_log[0][sent + 1] == 0x04 &&
+               (host_tx_log[0][sent + 2] << 8 | host_tx_log[0][sent + 3]) == reported[i],
+               "clock statistic not reported");
+    }
+
+    if (failures) return 1;
+    printf("clock switches wait for a quiet line or a stop bit, %u byte lost to a switch counted\n", switch_lost_bytes);
+    return 0;
+}
@@ -0,0 +1,156 @@
+// Runs the ClosedLoopPWM.c control loop against a simulated plant: the plant's
+// output duty follows the TB1.1 drive duty through a first-order lag, and its
+// edges go through the Timer A1 capture ISR. Setpoint steps and the jitter and
+// settling reports go through the packet interface, as from the PC.
+//
+//     closed_loop_plant [time constant in ms] [seed]
+
+#define main firmware_main
+#include "ClosedLoopPWM.c"
+#undef main
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_TAU_MS 50
+#define MIN_LATENCY 6                // Timer tick to Control_Loop_ISR, SMCLK ticks
+#define LATENCY_SPREAD 24            // Injected latencies are MIN_LATENCY .. MIN_LATENCY + LATENCY_SPREAD - 1
+#define MAX_SETTLING 100             // Loop periods (1 s) a step may take to settle
+#define STEP_PERIODS 1000            // PWM periods (2 s) simulated per step
+
+static double plant_duty;            // Plant output duty, 0 .. 1
+static double lag;                   // Fraction of the gap the plant closes per PWM period
+static unsigned long now;            // SMCLK ticks
+static unsigned long seed;
+static unsigned int injected_min = 0xFFFF, injected_max;
+static unsigned long tx_read;
+
+static unsigned int next_latency(void) {
+    seed = seed * 1103515245UL + 12345;
+    return MIN_LATENCY + (seed >> 16) % LATENCY_SPREAD;
+}
+
+static void capture_edge(unsigned long time, int rising) {
+    TA1CCR1 = time;
+    if (rising) TA1CCTL1 |= CCI;
+    else TA1CCTL1 &= ~CCI;
+    TA1IV = TA1IV_TACCR1;
+    Timer_A_Capture_ISR();
+}
+
+static void control_tick(unsigned int latency) {
+    if (latency < injected_min) injected_min = latency;
+    if (latency > injected_max) injected_max = latency;
+    TA0R = latency;
+    Control_Loop_ISR();
+}
+
+// One PWM period. TB1CCR1 was latched when it started (CLLD_1), and the plant
+// output is high for its duty from the start of the period
+static void pwm_period(void) {
+    double drive = (double)TB1CCR1 / PWM_PERIOD;
+    unsigned long high;
+    int control = (now % CONTROL_PERIOD) == 0;
+    unsigned int latency = control ? next_latency() : 0;
+
+    plant_duty += (drive > 1 ? 1 : drive) * lag - plant_duty * lag;
+    high = (unsigned long)(plant_duty * PWM_PERIOD + 0.5);
+
+    if (high == 0 || high >= PWM_PERIOD) {
+        // No edges: the capture input just sits at the level
+        if (high == 0) TA1CCTL1 &= ~CCI;
+        else TA1CCTL1 |= CCI;
+        if (control) control_tick(latency);
+    } else {
+        capture_edge(now, 1);
+        if (control && latency < high) control_tick(latency);
+        capture_edge(now + high, 0);
+        if (control && latency >= high) control_tick(latency);
+    }
+    now += PWM_PERIOD;
+}
+
+// Send a command packet and decode the response packet every command gets
+static int send_command(unsigned char command, unsigned int data) {
+    unsigned char upper = data >> 8, lower = data & 0xFF, escape = 0;
+    unsigned char packet[PACKET_SIZE];
+    unsigned int i;
+
+    if (upper == 0xFF) { escape |= 0x01; upper = 0; }
+    if (lower == 0xFF) { escape |= 0x02; lower = 0; }
+    circular_buffer_add(START_BYTE);
+    circular_buffer_add(command);
+    circular_buffer_add(upper);
+    circular_buffer_add(lower);
+    circular_buffer_add(escape);
+    process_packets();
+
+    while (host_uart_vector(0)) uart_ISR(); // Send the queued response
+    host_uart_flush(0);
+    if (host_tx_count[0] - tx_read != PACKET_SIZE) return -1;
+    for (i = 0; i < PACKET_SIZE; i++) packet[i] = host_tx_log[0][tx_read++ % HOST_TX_LOG_SIZE];
+    if (packet[0] != START_BYTE || packet[1] != command) return -1;
+    return ((packet[4] & 0x01) ? 0xFF00 : packet[2] << 8) | ((packet[4] & 0x02) ? 0xFF : packet[3]);
+}
+
+// Step the setpoint, run the loop and check the step settles without a large overshoot
+static int step(unsigned int target) {
+    unsigned int start = measured_duty, peak_over = 0, i;
+    int settling;
+
+    if (send_command(CMD_SETPOINT, target) != (int)target) {
+        fprintf(stderr, "FAIL: setpoint %u not acknowledged\n", target);
+        return 1;
+    }
+    for (i = 0; i < STEP_PERIODS; i++) {
+        unsigned int over = (target > start) ? (measured_duty > target ? measured_duty - target : 0)
+                                             : (measured_duty < target ? target - measured_duty : 0);
+        if (over > peak_over) peak_over = over;
+        pwm_period();
+    }
+
+    settling = send_command(CMD_SETTLING, 0);
+    printf("step %4u -> %4u: settled in %d loop periods (%d ms), overshoot %u/%u, final duty %u\n",
+           start, target, settling, settling * (CONTROL_PERIOD / 1000), peak_over, DUTY_MAX, measured_duty);
+    if (settling <= 0 || settling > MAX_SETTLING) {
+        fprintf(stderr, "FAIL: the step did not settle within %u loop periods\n", MAX_SETTLING);
+        return 1;
+    }
+    if ((int)measured_duty - (int)target >= SETTLED_BAND || (int)target - (int)measured_duty >= SETTLED_BAND) {
+        fprintf(stderr, "FAIL: the loop drifted out of the settled band\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    double tau_ms = argc > 1 ? atof(argv[1]) : DEFAULT_TAU_MS;
+    int jitter;
+
+    seed = argc > 2 ? strtoul(argv[2], 0, 0) : 1;
+    if (tau_ms <= 0) {
+        fprintf(stderr, "usage: closed_loop_plant [time constant in ms] [seed]\n");
+        return 1;
+    }
+    lag = 1 - exp(-(double)PWM_PERIOD / (tau_ms * 1000));
+
+    host_reset();
+    configure_UART();
+    configure_timer_b();
+    configure_timer_a_capture();
+    configure_control_timer();
+    printf("plant time constant %.0f ms, gains kp %d ki %d kd %d (Q8), latency %u..%u ticks\n",
+           tau_ms, kp, ki, kd, MIN_LATENCY, MIN_LATENCY + LATENCY_SPREAD - 1);
+
+    // Settle at the default setpoint, then step up, down, into saturation and back
+    if (step(DUTY_MAX / 2) || step(800) || step(100) || step(DUTY_MAX) || step(DUTY_MAX / 2)) return 1;
+
+    jitter = send_command(CMD_JITTER, 0);
+    printf("control loop jitter %d ticks\n", jitter);
+    if (jitter != (int)(injected_max - injected_min)) {
+        fprintf(stderr, "FAIL: reported jitter %d, injected %u\n", jitter, injected_max - injected_min);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Checks EnableUART.c on the UartTransport.h queues: every byte is echoed with
+// the next ASCII byte in order, LED1 follows 'j' and 'k', and a burst longer
+// than the queues is held back rather than losing replies. Interrupts go through
+// the stub's UCA0IV model, so a transmitter that went idle (TXIFG read away by
+// the ISR) has to be restarted by uart_write for a later burst to go out
+
+#define main firmware_main
+#include "EnableUART.c"
+#undef main
+
+#include <stdio.h>
+
+static unsigned long tx_read;
+
+// One RX interrupt (it outranks TX, so a queued reply is not sent meanwhile)
+static void receive(unsigned char byte) {
+    host_uart_receive(0, byte);
+    if (host_uart_vector(0) == USCI_UART_UCRXIFG) uart_ISR();
+}
+
+// Take interrupts until none is pending, i.e. the transmitter has gone idle
+static void transmit_all(void) {
+    while (host_uart_vector(0)) uart_ISR();
+}
+
+// Check the next replies on the wire
+static int expect(const unsigned char *sent, unsigned int length) {
+    unsigned int i;
+    for (i = 0; i < length; i++) {
+        unsigned char echo = host_tx_log[0][tx_read++ % HOST_TX_LOG_SIZE];
+        unsigned char next = host_tx_log[0][tx_read++ % HOST_TX_LOG_SIZE];
+        if (tx_read > host_tx_count[0] || echo != sent[i] || next != (unsigned char)(sent[i] + 1)) {
+            fprintf(stderr, "FAIL: byte %u (%02X) answered with %02X %02X\n", i, sent[i], echo, next);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    static const unsigned char hello[] = "hij";
+    unsigned char burst[UART_RX_SIZE];
+    unsigned int i;
+
+    host_reset();
+    configure_UART();
+    configure_LED();
+    if (UCA0BRW != 104 || UCA0MCTLW != 0xD600 || (UCA0CTLW0 & UCSWRST) || !(UCA0IE & UCRXIE)) {
+        fprintf(stderr, "FAIL: eUSCI_A0 is not set up for 9600 baud with the Rx interrupt\n");
+        return 1;
+    }
+
+    // One byte at a time, as typed
+    for (i = 0; i < 3; i++) {
+        receive(hello[i]);
+        echo_bytes();
+        transmit_all();
+    }
+    if (expect(hello, 3) || !(PJOUT & BIT0)) {
+        fprintf(stderr, "FAIL: LED1 should be on after 'j'\n");
+        return 1;
+    }
+    receive('k');
+    echo_bytes();
+    transmit_all();
+    if (expect((const unsigned char *)"k", 1) || (PJOUT & BIT0)) {
+        fprintf(stderr, "FAIL: LED1 should be off after 'k'\n");
+        return 1;
+    }
+
+    // A full RX queue while the transmitter is stalled: main takes only as many
+    // bytes as it has room to answer, the rest wait in the RX queue
+    for (i = 0; i < UART_RX_SIZE; i++) {
+        burst[i] = 'A' + i;
+        receive(burst[i]);
+    }
+    echo_bytes();
+    if ((unsigned char)(uart.rx_head - uart.rx_tail) != UART_RX_SIZE - UART_TX_SIZE / 2) {
+        fprintf(stderr, "FAIL: %u bytes left queued with a full TX queue\n",
+                (unsigned char)(uart.rx_head - uart.rx_tail));
+        return 1;
+    }
+    while (uart.rx_head != uart.rx_tail) {
+        transmit_all();
+        echo_bytes();
+    }
+    transmit_all();
+    if (expect(burst, UART_RX_SIZE) || tx_read != host_tx_count[0] || uart.stats.rx_dropped != 0) {
+        fprintf(stderr, "FAIL: the burst was not answered in full\n");
+        return 1;
+    }
+
+    // The transmitter is idle now and its TXIFG was read away by the last TX
+    // interrupt: a second burst must still go out
+    if ((UCA0IE & UCTXIE) || (UCA0IFG & UCTXIFG)) {
+        fprintf(stderr, "FAIL: transmitter not idle after the burst\n");
+        return 1;
+    }
+    for (i = 0; i < 4; i++) {
+        receive(burst[i]);
+    }
+    echo_bytes();
+    transmit_all();
+    if (expect(burst, 4) || tx_read != host_tx_count[0]) {
+        fprintf(stderr, "FAIL: the second burst was not sent after the transmitter went idle\n");
+        return 1;
+    }
+
+    printf("%u bytes received, %u sent, %u dropped\n",
+           uart.stats.rx_bytes, uart.stats.tx_bytes, uart.stats.rx_dropped);
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Fuzz test for the CircularQueue.c echo ISR on the UartTransport.h queues.
+//
+// An input is a sequence of (event, byte) pairs: a byte arriving (RX interrupt),
+// one TX interrupt, one pass of the main loop's 'A' writer, or the transmitter
+// draining its queue. A model of the circular buffer and of the TX queue's fill
+// predicts every byte the firmware sends: echoes on carriage return, 'E' for a
+// full buffer, 'U' for an empty one, and main's 'A's, each only if the TX queue
+// had room. At the end the transmitter must drain the whole queue, even if it
+// went idle in between
+
+#define main firmware_main
+#include "CircularQueue.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define EXPECTED_SIZE 256            // More than UART_TX_SIZE bytes can't be waiting
+
+enum { EVENT_RECEIVE, EVENT_TRANSMIT, EVENT_MAIN, EVENT_DRAIN };
+
+static unsigned char model_buffer[BUFFER_SIZE];
+static unsigned int model_head, model_count;
+static unsigned char expected[EXPECTED_SIZE];
+static unsigned long written, checked;   // Bytes the model queued for TX, and bytes compared on the wire
+static unsigned long echoes, errors, dropped, sent_a;
+
+static unsigned long fuzz_state = 1;
+
+static unsigned long fuzz_random(void) {
+    fuzz_state ^= fuzz_state << 13;
+    fuzz_state ^= fuzz_state >> 7;
+    fuzz_state ^= fuzz_state << 17;
+    return fuzz_state;
+}
+
+// The firmware queues a byte if the model's TX queue has room
+static void model_write(unsigned char byte) {
+    if (written - host_tx_count[0] < UART_TX_SIZE) {
+        expected[written++ % EXPECTED_SIZE] = byte;
+    } else {
+        dropped++;
+    }
+}
+
+// Compare everything sent since the last check with the model
+static int check_wire(void) {
+    while (checked < host_tx_count[0]) {
+        unsigned char byte = host_tx_log[0][checked % HOST_TX_LOG_SIZE];
+        if (checked >= written || byte != expected[checked % EXPECTED_SIZE]) {
+            fprintf(stderr, "FAIL: byte %lu sent as %02X, expected %02X\n", checked, byte,
+                    checked < written ? expected[checked % EXPECTED_SIZE] : 0);
+            return 1;
+        }
+        checked++;
+    }
+    if (count != model_count || head != model_head || tail >= BUFFER_SIZE || (tail + count) % BUFFER_SIZE != head) {
+        fprintf(stderr, "FAIL: buffer head %u tail %u count %u, model head %u count %u\n",
+                head, tail, count, model_head, model_count);
+        return 1;
+    }
+    return 0;
+}
+
+static void transmit_one(void) {
+    if (host_uart_vector(0)) uart_ISR();
+    host_uart_flush(0);                  // The shift register finishes the byte
+}
+
+static void reset(void) {
+    host_reset();
+    head = tail = count = 0;
+    configure_UART();
+    model_head = model_count = 0;
+    written = checked = 0;
+}
+
+static int run(const unsigned char *data, unsigned long size) {
+    unsigned long i;
+
+    reset();
+    for (i = 0; i + 1 < size; i += 2) {
+        unsigned char byte = data[i + 1];
+
+        switch (data[i] & 3) {
+            case EVENT_RECEIVE:
+                if (byte != 13) {
+                    if (model_count < BUFFER_SIZE) {
+                        model_buffer[model_head] = byte;
+                        model_head = (model_head + 1) % BUFFER_SIZE;
+                        model_count++;
+                    } else {
+                        model_write('E');
+                        errors++;
+                    }
+                } else if (model_count > 0) {
+                    model_write(model_buffer[(model_head + BUFFER_SIZE - model_count) % BUFFER_SIZE]);
+                    model_count--;
+                    echoes++;
+                } else {
+                    model_write('U');
+                    errors++;
+                }
+                host_uart_receive(0, byte);
+                if (host_uart_vector(0) == USCI_UART_UCRXIFG) uart_ISR();
+                break;
+            case EVENT_TRANSMIT:
+                transmit_one();
+                break;
+            case EVENT_MAIN:                 // One pass of main's loop
+                if (UART_TX_SIZE - (written - host_tx_count[0]) > TX_RESERVE) {
+                    model_write('A');
+                    sent_a++;
+                }
+                if (uart_tx_space(&uart) > TX_RESERVE) uart_write(&uart, 'A');
+                break;
+            default:
+                while (host_uart_vector(0)) {
+                    uart_ISR();
+                    host_uart_flush(0);
+                }
+                break;
+        }
+        if (check_wire()) return 1;
+    }
+
+    // Whatever is queued must still go out
+    for (i = 0; i <= UART_TX_SIZE; i++) transmit_one();
+    if (check_wire()) return 1;
+    if (checked != written) {
+        fprintf(stderr, "FAIL: %lu of %lu queued bytes sent\n", checked, written);
+        return 1;
+    }
+    return 0;
+}
+
+#ifdef LIBFUZZER
+int LLVMFuzzerTestOneInput(const unsigned char *data, unsigned long size) {
+    if (run(data, size)) abort();
+    return 0;
+}
+#else
+int main(int argc, char **argv) {
+    static unsigned char data[4096];
+    unsigned int r;
+
+    fuzz_state = argc > 1 ? strtoul(argv[1], NULL, 0) : 1;
+    if (fuzz_state == 0) fuzz_state = 1;
+
+    for (r = 0; r < 2000; r++) {
+        unsigned long size = fuzz_random() % sizeof(data), i;
+        unsigned int weights = fuzz_random();   // Mix of events differs between runs
+        for (i = 0; i + 1 < size; i += 2) {
+            data[i] = fuzz_random() % 16 < (weights & 15) ? EVENT_RECEIVE : fuzz_random() & 3;
+            data[i + 1] = (fuzz_random() & 3) == 0 ? 13 : (unsigned char)fuzz_random();
+        }
+        if (run(data, size)) {
+            fprintf(stderr, "FAIL: run %u, seed %lu\n", r, fuzz_state);
+            return 1;
+        }
+    }
+    printf("CircularQueue: 2000 inputs, %lu echoes, %lu E/U errors, %lu 'A's, %lu replies dropped on a full TX queue\n",
+           echoes, errors, sent_a, dropped);
+    return 0;
+}
+#endif
@@ -0,0 +1,40 @@
+// Fuzz and resync test for the ClosedLoopPWM.c packet parser
+
+#define main firmware_main
+#include "ClosedLoopPWM.c"
+#undef main
+
+#include "parser_fuzz.h"
+
+static unsigned int queued(void) {
+    return count;
+}
+
+static void reset(void) {
+    head = tail = count = 0;
+    configure_UART();
+}
+
+// The gain commands answer with the gain they set
+static unsigned char command(unsigned long r) {
+    return CMD_KP + r % 3;
+}
+
+static unsigned char response(unsigned char sent) {
+    return sent;
+}
+
+static const struct parser_target target = {
+    "ClosedLoopPWM", fuzz_uart_receive, process_packets, queued, reset, command, response
+};
+
+#ifdef LIBFUZZER
+int LLVMFuzzerTestOneInput(const unsigned char *data, unsigned long size) {
+    if (parser_fuzz_one(&target, data, size)) abort();
+    return 0;
+}
+#else
+int main(int argc, char **argv) {
+    return parser_fuzz_main(&target, argc, argv);
+}
+#endif
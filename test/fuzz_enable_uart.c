@@ -0,0 +1,169 @@
+// Fuzz test for the EnableUART.c echo on the UartTransport.h queues.
+//
+// An input is a sequence of (event, byte) pairs: a byte arriving (RX interrupt),
+// one TX interrupt, one echo_bytes() pass of the main loop, or the transmitter
+// draining its queue. A model of both queues predicts which bytes the ISR
+// drops on a full RX queue and which ones main takes: a byte is only taken
+// once its echo and the next ASCII byte fit in the TX queue, so every taken
+// byte must come back as that pair, in order, and LED1 must follow 'j' and 'k'.
+// At the end every queued byte must be answered and sent
+
+#define main firmware_main
+#include "EnableUART.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define EXPECTED_SIZE 256            // More than UART_TX_SIZE bytes can't be waiting
+
+enum { EVENT_RECEIVE, EVENT_TRANSMIT, EVENT_MAIN, EVENT_DRAIN };
+
+static unsigned char model_rx[UART_RX_SIZE];
+static unsigned int model_rx_head, model_rx_count;
+static unsigned char model_led;
+static unsigned char expected[EXPECTED_SIZE];
+static unsigned long written, checked;   // Bytes the model queued for TX, and bytes compared on the wire
+static unsigned long echoed, dropped;
+
+static unsigned long fuzz_state = 1;
+
+static unsigned long fuzz_random(void) {
+    fuzz_state ^= fuzz_state << 13;
+    fuzz_state ^= fuzz_state >> 7;
+    fuzz_state ^= fuzz_state << 17;
+    return fuzz_state;
+}
+
+// echo_bytes() as the model sees it
+static void model_echo(void) {
+    while (UART_TX_SIZE - (written - host_tx_count[0]) >= 2 && model_rx_count > 0) {
+        unsigned char byte = model_rx[(model_rx_head + UART_RX_SIZE - model_rx_count) % UART_RX_SIZE];
+        model_rx_count--;
+        expected[written++ % EXPECTED_SIZE] = byte;
+        expected[written++ % EXPECTED_SIZE] = byte + 1;
+        if (byte == 'j') model_led = 1;
+        if (byte == 'k') model_led = 0;
+        echoed++;
+    }
+}
+
+// Compare everything sent since the last check, the RX queue and LED1 with the model
+static int check_wire(void) {
+    while (checked < host_tx_count[0]) {
+        unsigned char byte = host_tx_log[0][checked % HOST_TX_LOG_SIZE];
+        if (checked >= written || byte != expected[checked % EXPECTED_SIZE]) {
+            fprintf(stderr, "FAIL: byte %lu sent as %02X, expected %02X\n", checked, byte,
+                    checked < written ? expected[checked % EXPECTED_SIZE] : 0);
+            return 1;
+        }
+        checked++;
+    }
+    if ((unsigned char)(uart.rx_head - uart.rx_tail) != model_rx_count || uart.stats.rx_dropped != dropped ||
+        !(PJOUT & BIT0) != !model_led) {
+        fprintf(stderr, "FAIL: %u bytes queued (model %u), %u dropped (model %lu), LED1 %u (model %u)\n",
+                (unsigned char)(uart.rx_head - uart.rx_tail), model_rx_count, uart.stats.rx_dropped, dropped,
+                !!(PJOUT & BIT0), model_led);
+        return 1;
+    }
+    return 0;
+}
+
+static void transmit_one(void) {
+    if (host_uart_vector(0)) uart_ISR();
+    host_uart_flush(0);                  // The shift register finishes the byte
+}
+
+static void reset(void) {
+    host_reset();
+    configure_UART();
+    configure_LED();
+    uart.stats.rx_dropped = 0;
+    model_rx_head = model_rx_count = 0;
+    model_led = 0;
+    written = checked = 0;
+    dropped = 0;
+}
+
+static int run(const unsigned char *data, unsigned long size) {
+    unsigned long i;
+
+    reset();
+    for (i = 0; i + 1 < size; i += 2) {
+        unsigned char byte = data[i + 1];
+
+        switch (data[i] & 3) {
+            case EVENT_RECEIVE:
+                if (model_rx_count < UART_RX_SIZE) {
+                    model_rx[model_rx_head] = byte;
+                    model_rx_head = (model_rx_head + 1) % UART_RX_SIZE;
+                    model_rx_count++;
+                } else {
+                    dropped++;
+                }
+                host_uart_receive(0, byte);
+                if (host_uart_vector(0) == USCI_UART_UCRXIFG) uart_ISR();
+                break;
+            case EVENT_TRANSMIT:
+                transmit_one();
+                break;
+            case EVENT_MAIN:
+                model_echo();
+                echo_bytes();
+                break;
+            default:
+                while (host_uart_vector(0)) {
+                    uart_ISR();
+                    host_uart_flush(0);
+                }
+                break;
+        }
+        if (check_wire()) return 1;
+    }
+
+    // Main and the transmitter catch up: every queued byte is answered and sent
+    for (i = 0; i <= UART_RX_SIZE; i++) {
+        unsigned int j;
+        model_echo();
+        echo_bytes();
+        for (j = 0; j <= UART_TX_SIZE; j++) transmit_one();
+        if (check_wire()) return 1;
+    }
+    if (model_rx_count != 0 || checked != written) {
+        fprintf(stderr, "FAIL: %u bytes never answered, %lu of %lu replies sent\n", model_rx_count, checked, written);
+        return 1;
+    }
+    return 0;
+}
+
+#ifdef LIBFUZZER
+int LLVMFuzzerTestOneInput(const unsigned char *data, unsigned long size) {
+    if (run(data, size)) abort();
+    return 0;
+}
+#else
+int main(int argc, char **argv) {
+    static unsigned char data[4096];
+    unsigned long total_dropped = 0;
+    unsigned int r;
+
+    fuzz_state = argc > 1 ? strtoul(argv[1], NULL, 0) : 1;
+    if (fuzz_state == 0) fuzz_state = 1;
+
+    for (r = 0; r < 2000; r++) {
+        unsigned long size = fuzz_random() % sizeof(data), i;
+        unsigned int weights = fuzz_random();   // Mix of events differs between runs
+        for (i = 0; i + 1 < size; i += 2) {
+            data[i] = fuzz_random() % 16 < (weights & 15) ? EVENT_RECEIVE : fuzz_random() & 3;
+            data[i + 1] = (fuzz_random() & 7) == 0 ? 'j' + (fuzz_random() & 1) : (unsigned char)fuzz_random();
+        }
+        if (run(data, size)) {
+            fprintf(stderr, "FAIL: run %u, seed %lu\n", r, fuzz_state);
+            return 1;
+        }
+        total_dropped += dropped;
+    }
+    printf("EnableUART: 2000 inputs, %lu bytes echoed, %lu dropped on a full RX queue\n", echoed, total_dropped);
+    return 0;
+}
+#endif
@@ -0,0 +1,57 @@
+// Fuzz and resync test for the SerialCommunicator.c packet parser
+
+#define main firmware_main
+#include "SerialCommunicator.c"
+#undef main
+
+#include "parser_fuzz.h"
+
+static unsigned int queued(void) {
+    return count;
+}
+
+static void reset(void) {
+    head = tail = count = 0;
+    configure_UART();
+}
+
+// Timer commands (0x01) answer with 0x02 and the period they set
+static unsigned char command(unsigned long r) {
+    (void)r;
+    return 0x01;
+}
+
+static unsigned char response(unsigned char sent) {
+    (void)sent;
+    return 0x02;
+}
+
+static const struct parser_target target = {
+    "SerialCommunicator", fuzz_uart_receive, process_packets, queued, reset, command, response
+};
+
+// A truncated packet right before a real one must not swallow it
+static int truncated_then_real(void) {
+    static const unsigned char stream[] = { 0xFF, 0x01, 0xFF, 0x01, 0x00, 0x12, 0x00 };
+    unsigned int i;
+    fuzz_start(&target);
+    for (i = 0; i < sizeof(stream); i++) fuzz_uart_receive(stream[i]);
+    process_packets();
+    if (TB1CCR0 != 0x0012 - 1 || count != 0) {
+        fprintf(stderr, "FAIL: FF 01 FF 01 00 12 00 set period %04X with %u bytes left\n", TB1CCR0 + 1, count);
+        return 1;
+    }
+    return 0;
+}
+
+#ifdef LIBFUZZER
+int LLVMFuzzerTestOneInput(const unsigned char *data, unsigned long size) {
+    if (parser_fuzz_one(&target, data, size)) abort();
+    return 0;
+}
+#else
+int main(int argc, char **argv) {
+    if (truncated_then_real()) return 1;
+    return parser_fuzz_main(&target, argc, argv);
+}
+#endif
@@ -0,0 +1,329 @@
+// Fuzz and resynchronization harness for the 5-byte packet parsers
+// (start byte, command, data byte 1, data byte 2, escape byte).
+//
+// A test #includes one firmware program, fills in a struct parser_target and
+// includes this file. Two kinds of input are run:
+//
+// - Synthetic streams: intact packets mixed with noise bursts, truncated
+//   packets, corrupted packets and packets with a byte missing. Every intact
+//   packet must be answered by the time its last byte has been parsed, both
+//   when the main loop parses after every byte and when bytes arrive in bursts
+//   of up to RX_BURST_MAX. Reports parse throughput and bytes-to-resync: the
+//   bytes from the first corrupted byte to the end of the next packet the
+//   parser answers correctly.
+// - Arbitrary inputs (random here, coverage-guided under libFuzzer): after any
+//   input an intact packet must still be answered, and the parser must never
+//   leave a whole packet's worth of bytes unparsed.
+//
+// The parser is never allowed to stall: the RX queue must hold fewer than
+// PACKET_SIZE bytes after every process_packets() call, and an alarm aborts a
+// run that takes unbounded work.
+
+#ifndef PARSER_FUZZ_H
+#define PARSER_FUZZ_H
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RX_BURST_MAX 40              // Bytes queued before the main loop parses (BUFFER_SIZE is 50)
+#define MAX_SEGMENTS 100000          // Segments per synthetic stream
+#define MAX_EXPECTED 64              // Intact packets that may be waiting for a response
+
+struct parser_target {
+    const char *name;
+    void (*receive)(unsigned char byte);         // Deliver one byte through the UART ISR
+    void (*process)(void);                       // Run the main loop's parser
+    unsigned int (*queued)(void);                // Bytes waiting in the RX queue
+    void (*reset)(void);                         // Empty the RX queue and set up the UART again
+    unsigned char (*command)(unsigned long r);   // A command that answers with its own value
+    unsigned char (*response)(unsigned char command); // Command byte of the answer
+};
+
+struct expected_packet {
+    unsigned char command;
+    unsigned int value;
+    unsigned long last_byte;         // Stream index of the packet's escape byte
+    unsigned long corruption_start;  // Stream index of the first byte of the preceding corruption, or ~0
+};
+
+struct fuzz_stats {
+    unsigned long bytes;
+    unsigned long packets;           // Intact packets sent
+    unsigned long answered;
+    unsigned long spurious;          // Answers to packets formed by noise
+    unsigned long corruptions;
+    unsigned long resyncs;           // Intact packets that followed a corruption
+    unsigned long resync_bytes_total;
+    unsigned long resync_bytes_max;
+    double total_ns;
+};
+
+static unsigned long fuzz_state = 1;
+static unsigned long tx_read;        // Bytes of host_tx_log already decoded
+static unsigned char answer[5];
+static unsigned int answer_length;
+
+static unsigned long fuzz_random(void) {
+    fuzz_state ^= fuzz_state << 13;
+    fuzz_state ^= fuzz_state >> 7;
+    fuzz_state ^= fuzz_state << 17;
+    return fuzz_state;
+}
+
+static double fuzz_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void fuzz_timeout(int signal_number) {
+    (void)signal_number;
+    fprintf(stderr, "FAIL: parser did not finish (unbounded work), seed %lu\n", fuzz_state);
+    _exit(1);
+}
+
+// A data byte, biased towards the start byte so the escape bits get exercised
+static unsigned char fuzz_data_byte(void) {
+    return (fuzz_random() & 3) == 0 ? 0xFF : (unsigned char)fuzz_random();
+}
+
+// Encode a packet the way the PC sends it
+static void fuzz_encode(unsigned char command, unsigned int value, unsigned char *packet) {
+    unsigned char upper = value >> 8, lower = value & 0xFF, escape = 0;
+    if (upper == 0xFF) { upper = 0; escape |= 0x01; }
+    if (lower == 0xFF) { lower = 0; escape |= 0x02; }
+    packet[0] = START_BYTE;
+    packet[1] = command;
+    packet[2] = upper;
+    packet[3] = lower;
+    packet[4] = escape;
+}
+
+// Take UART interrupts until none is pending (every target names its USCI_A0 ISR uart_ISR)
+static void fuzz_uart_service(void) {
+    while (host_uart_vector(0)) uart_ISR();
+}
+
+// A byte arrives on the UART
+static void fuzz_uart_receive(unsigned char byte) {
+    host_uart_receive(0, byte);
+    fuzz_uart_service();
+}
+
+// Decode the next answer from the UART log. Returns 1 for an answer, 0 if no
+// complete answer is waiting and -1 if the firmware sent a malformed one
+static int fuzz_next_answer(unsigned char *command, unsigned int *value) {
+    fuzz_uart_service();                         // Send what the firmware queued
+    host_uart_flush(0);
+    while (tx_read < host_tx_count[0]) {
+        unsigned char byte = host_tx_log[0][tx_read++ % HOST_TX_LOG_SIZE];
+        if (answer_length == 0 && byte != START_BYTE) return -1;
+        answer[answer_length++] = byte;
+        if (answer_length == PACKET_SIZE) {
+            answer_length = 0;
+            *command = answer[1];
+            *value = ((answer[4] & 0x01) ? 0xFF00 : (unsigned int)answer[2] << 8) |
+                     ((answer[4] & 0x02) ? 0x00FF : answer[3]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void fuzz_start(const struct parser_target *target) {
+    host_reset();
+    target->reset();
+    tx_read = 0;
+    answer_length = 0;
+}
+
+// One synthetic stream. burst = 0 parses after every byte, otherwise the main
+// loop parses after random bursts of up to RX_BURST_MAX bytes
+static int fuzz_stream(const struct parser_target *target, unsigned long segments, int burst,
+                       struct fuzz_stats *stats) {
+    static struct expected_packet expected[MAX_EXPECTED];
+    unsigned int first = 0, pending = 0;
+    unsigned long index = 0, corruption_start = ~0UL;
+    unsigned int queued_bytes = 0, burst_length = 1;
+    unsigned long s;
+
+    fuzz_start(target);
+    memset(stats, 0, sizeof(*stats));
+
+    for (s = 0; s < segments; s++) {
+        unsigned char bytes[16];
+        unsigned int length = 0, i;
+        unsigned char command = target->command(fuzz_random());
+        unsigned int value = (fuzz_data_byte() << 8) | fuzz_data_byte();
+        unsigned int kind = fuzz_random() % 8;
+        int intact = kind < 4;
+
+        fuzz_encode(command, value, bytes);
+        if (intact) {
+            length = PACKET_SIZE;
+        } else if (kind == 4) {                  // Noise burst
+            length = 1 + fuzz_random() % 8;
+            for (i = 0; i < length; i++) bytes[i] = fuzz_data_byte();
+        } else if (kind == 5) {                  // Truncated packet
+            length = 1 + fuzz_random() % (PACKET_SIZE - 1);
+        } else if (kind == 6) {                  // One byte corrupted
+            length = PACKET_SIZE;
+            bytes[fuzz_random() % PACKET_SIZE] = (unsigned char)fuzz_random();
+        } else {                                 // One byte lost
+            unsigned int lost = fuzz_random() % PACKET_SIZE;
+            for (i = lost; i < PACKET_SIZE - 1; i++) bytes[i] = bytes[i + 1];
+            length = PACKET_SIZE - 1;
+        }
+
+        if (intact) {
+            struct expected_packet *packet = &expected[(first + pending++) % MAX_EXPECTED];
+            packet->command = target->response(command);
+            packet->value = value;
+            packet->last_byte = index + PACKET_SIZE - 1;
+            packet->corruption_start = corruption_start;
+            corruption_start = ~0UL;
+            stats->packets++;
+        } else {
+            if (corruption_start == ~0UL) corruption_start = index;
+            stats->corruptions++;
+        }
+
+        for (i = 0; i < length; i++, index++) {
+            double start = fuzz_now_ns();
+            int parse;
+            target->receive(bytes[i]);
+            queued_bytes++;
+            parse = burst == 0 || queued_bytes >= burst_length || (s + 1 == segments && i + 1 == length);
+            if (parse) target->process();
+            stats->total_ns += fuzz_now_ns() - start;
+            if (!parse) continue;
+
+            queued_bytes = 0;
+            burst_length = 1 + fuzz_random() % RX_BURST_MAX;
+            if (target->queued() >= PACKET_SIZE) {
+                fprintf(stderr, "FAIL %s: parser stalled with %u bytes queued at byte %lu\n",
+                        target->name, target->queued(), index);
+                return 1;
+            }
+
+            // Match the answers against the intact packets, oldest first
+            unsigned char answer_command;
+            unsigned int answer_value;
+            int status;
+            while ((status = fuzz_next_answer(&answer_command, &answer_value)) != 0) {
+                if (status < 0) {
+                    fprintf(stderr, "FAIL %s: malformed answer at byte %lu\n", target->name, index);
+                    return 1;
+                }
+                struct expected_packet *packet = &expected[first % MAX_EXPECTED];
+                if (pending && packet->last_byte <= index &&
+                    packet->command == answer_command && packet->value == answer_value) {
+                    if (burst == 0 && packet->corruption_start != ~0UL) {
+                        unsigned long resync = index + 1 - packet->corruption_start;
+                        stats->resyncs++;
+                        stats->resync_bytes_total += resync;
+                        if (resync > stats->resync_bytes_max) stats->resync_bytes_max = resync;
+                    }
+                    first++;
+                    pending--;
+                    stats->answered++;
+                } else {
+                    stats->spurious++;
+                }
+            }
+
+            // Every intact packet received so far must have been answered
+            if (pending && expected[first % MAX_EXPECTED].last_byte <= index) {
+                struct expected_packet *packet = &expected[first % MAX_EXPECTED];
+                fprintf(stderr, "FAIL %s: lost packet %02X %04X ending at byte %lu (seed %lu)\n",
+                        target->name, packet->command, packet->value, packet->last_byte, fuzz_state);
+                return 1;
+            }
+        }
+    }
+    stats->bytes = index;
+    if (stats->answered != stats->packets) {
+        fprintf(stderr, "FAIL %s: %lu of %lu packets answered\n", target->name, stats->answered, stats->packets);
+        return 1;
+    }
+    return 0;
+}
+
+// Arbitrary input: parse it in bursts, then check an intact packet still gets through
+static int parser_fuzz_one(const struct parser_target *target, const unsigned char *data, unsigned long size) {
+    unsigned char packet[PACKET_SIZE], command = target->command(0), answer_command = 0;
+    unsigned int answer_value = 0, found = 0;
+    unsigned long i;
+
+    fuzz_start(target);
+    for (i = 0; i < size; i++) {
+        target->receive(data[i]);
+        if (target->queued() >= RX_BURST_MAX || i + 1 == size) {
+            target->process();
+            if (target->queued() >= PACKET_SIZE) {
+                fprintf(stderr, "FAIL %s: parser stalled with %u bytes queued\n", target->name, target->queued());
+                return 1;
+            }
+        }
+    }
+    while (fuzz_next_answer(&answer_command, &answer_value) > 0) {
+    }
+
+    fuzz_encode(command, 0x1234, packet);
+    for (i = 0; i < PACKET_SIZE; i++) {
+        target->receive(packet[i]);
+        target->process();
+    }
+    int status;
+    while ((status = fuzz_next_answer(&answer_command, &answer_value)) > 0) {
+        found = answer_command == target->response(command) && answer_value == 0x1234;
+    }
+    if (status < 0 || !found) {
+        fprintf(stderr, "FAIL %s: packet after %lu bytes of arbitrary input was not answered\n", target->name, size);
+        return 1;
+    }
+    return 0;
+}
+
+// Resync distances are only measured when every byte is parsed
+static void fuzz_report(const struct parser_target *target, const char *mode, const struct fuzz_stats *stats) {
+    printf("%s (%s): %lu bytes, %lu/%lu packets answered, %lu spurious, %.1f Mbyte/s",
+           target->name, mode, stats->bytes, stats->answered, stats->packets, stats->spurious,
+           stats->bytes / stats->total_ns * 1e3);
+    if (stats->resyncs > 0) {
+        printf(", resync after %lu corruptions: mean %.2f max %lu bytes",
+               stats->resyncs, (double)stats->resync_bytes_total / stats->resyncs, stats->resync_bytes_max);
+    }
+    printf("\n");
+}
+
+// Synthetic streams in both parsing modes, then random arbitrary inputs
+static int parser_fuzz_main(const struct parser_target *target, int argc, char **argv) {
+    struct fuzz_stats stats;
+    unsigned long seed = argc > 1 ? strtoul(argv[1], NULL, 0) : 1;
+    unsigned int run;
+    static unsigned char data[512];
+
+    signal(SIGALRM, fuzz_timeout);
+    alarm(60);
+    fuzz_state = seed ? seed : 1;
+
+    if (fuzz_stream(target, MAX_SEGMENTS, 0, &stats)) return 1;
+    fuzz_report(target, "parse every byte", &stats);
+    if (fuzz_stream(target, MAX_SEGMENTS, 1, &stats)) return 1;
+    fuzz_report(target, "parse in bursts", &stats);
+
+    for (run = 0; run < 2000; run++) {
+        unsigned long size = fuzz_random() % sizeof(data), i;
+        for (i = 0; i < size; i++) data[i] = fuzz_data_byte();
+        if (parser_fuzz_one(target, data, size)) return 1;
+    }
+    printf("%s: 2000 arbitrary inputs, an intact packet was answered after each\n", target->name);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,182 @@
+// Checks the quadrature decoder in interrupt_set_blink_led_configure_clock.c:
+// the transition table, the highest edge rate the Port 4 ISR keeps up with and
+// that every count it misses is reported, and velocity when edges are further
+// apart than the 16-bit edge timer wraps.
+//
+//     quadrature_decoder [ISR cycles]
+//
+// The ISR cycle count (entry, body and exit at MCLK) is an estimate; the
+// cross_report target gives the compiled figure
+
+#define main firmware_main
+#include "interrupt_set_blink_led_configure_clock.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_ISR_CYCLES 100
+#define RATE_EDGES 20000                 // Edges per rate in the sweep
+
+static const unsigned char phases[4] = { 0, BIT0, BIT0 | BIT1, BIT1 };  // Forward sequence
+
+static void start(void) {
+    host_reset();
+    position = 0;
+    quadrature_errors = 0;
+    last_edge_time = 0;
+    edge_interval = 0;
+    edge_seen = 0;
+    edge_stale = 1;
+    configure_quadrature_decoder();
+}
+
+// Every legal transition in both directions, then a random walk
+static int check_table(void) {
+    unsigned int phase = 0, i;
+    long truth = 0;
+
+    start();
+    srand(5);
+    for (i = 0; i < 100000; i++) {
+        int step = (rand() % 3 == 0) ? -1 : 1;
+        phase = (phase + step) & 3;
+        truth += step;
+        P4IN = phases[phase];
+        Port_4_ISR();
+    }
+    if (position != truth || quadrature_errors != 0) {
+        fprintf(stderr, "FAIL: random walk decoded to %ld with %u errors, expected %ld\n",
+                position, quadrature_errors, truth);
+        return 1;
+    }
+
+    // Skip a state: both pins change at once, which can only be reported
+    P4IN = phases[(phase + 2) & 3];
+    Port_4_ISR();
+    if (position != truth || quadrature_errors != 1) {
+        fprintf(stderr, "FAIL: a skipped state moved the position or went unreported\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Forward edges every interval MCLK cycles. The ISR samples the pins when it
+// starts and can't start again until isr_cycles later, so faster edges are
+// seen two at a time (a reported error) or three at a time (a wrong count)
+static void run_rate(double interval, unsigned int isr_cycles, long *lost, unsigned int *errors) {
+    double next_isr = 0;
+    unsigned int edges = 0;
+
+    start();
+    while (edges < RATE_EDGES) {
+        double edge_time = (edges + 1) * interval;
+        edges++;
+        if (edge_time < next_isr) continue;  // The pin changes while the ISR is busy
+        if (edge_time > next_isr) next_isr = edge_time;
+        // The ISR starts at next_isr and sees every edge up to then
+        while ((edges + 1) * interval <= next_isr && edges < RATE_EDGES) edges++;
+        P4IN = phases[edges & 3];
+        Port_4_ISR();
+        next_isr += isr_cycles;
+    }
+    // The last edges are read once the encoder stops
+    P4IN = phases[edges & 3];
+    Port_4_ISR();
+    *lost = (long)edges - position;
+    *errors = quadrature_errors;
+}
+
+static int check_edge_rate(unsigned int isr_cycles) {
+    double interval;
+    double max_rate = 0;
+    long lost;
+    unsigned int errors;
+
+    for (interval = 4.0 * isr_cycles; interval >= isr_cycles / 2.0; interval *= 0.95) {
+        run_rate(interval, isr_cycles, &lost, &errors);
+        if (lost == 0 && errors == 0) {
+            max_rate = MCLK_HZ / interval;
+        } else if (interval > isr_cycles) {
+            fprintf(stderr, "FAIL: %lu missed counts with edges %.0f cycles apart, slower than the ISR\n",
+                    (unsigned long)lost, interval);
+            return 1;
+        } else if (interval >= isr_cycles / 2.0 && lost != 2L * errors) {
+            // Edges arrive at most two per ISR, so every miss is a double step
+            fprintf(stderr, "FAIL: %ld counts lost but %u errors reported at %.0f cycles\n", lost, errors, interval);
+            return 1;
+        }
+    }
+    run_rate(isr_cycles * 0.6, isr_cycles, &lost, &errors);
+    printf("ISR of %u cycles: up to %.0f edges/s decoded exactly; at %.0f edges/s %ld counts are lost, "
+           "all reported as %u errors\n", isr_cycles, max_rate, MCLK_HZ / (isr_cycles * 0.6), lost, errors);
+    if (max_rate < MCLK_HZ / (double)isr_cycles * 0.95 || lost == 0) {
+        fprintf(stderr, "FAIL: expected exact decoding up to one edge per ISR and losses beyond\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Edges every edge_ms milliseconds for 3 s, with a report every 0.1 s. Returns the
+// velocity from the last report, which always follows an edge
+static long slow_velocity(unsigned int edge_ms) {
+    unsigned long ms;
+    unsigned int phase = 0;
+
+    start();
+    velocity = 12345;
+    for (ms = 1; ms <= 3000; ms++) {
+        TA0R = (unsigned int)(ms * (EDGE_TIMER_HZ / 1000));
+        if (ms % edge_ms == 0) {
+            P4IN = phases[++phase & 3];
+            Port_4_ISR();
+        }
+        if (ms % 100 == 0) update_velocity();
+    }
+    return velocity;
+}
+
+// Edges less than two report windows apart are timed. Slower ones read as stopped
+// rather than being timed across a wrap of TA0R (0.524 s). The host registers
+// are wider than 16 bits and never wrap, so this checks slow edges aren't timed at all
+static int check_wrap(void) {
+    static const unsigned int edge_ms[] = { 5, 50, 150, 250, 600, 1000 };
+    unsigned int i;
+
+    for (i = 0; i < sizeof(edge_ms) / sizeof(edge_ms[0]); i++) {
+        long speed = slow_velocity(edge_ms[i]);
+        long expected = (edge_ms[i] < 200) ? EDGE_TIMER_HZ / (edge_ms[i] * (EDGE_TIMER_HZ / 1000)) : 0;
+        printf("edges every %4u ms: %ld counts/s\n", edge_ms[i], speed);
+        if (speed != expected) {
+            fprintf(stderr, "FAIL: expected %ld counts/s\n", expected);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// The position LEDs must leave the SMCLK output on P3.4 alone
+static int check_clock_output(void) {
+    host_reset();
+    configure_clocks();
+    configure_position_leds();
+    position = 0x7F;
+    show_position();
+    if (!(P3SEL0 & BIT4) || !(P3SEL1 & BIT4) || !(P3DIR & BIT4) || (P3OUT & BIT4) ||
+        (P3OUT & 0xE0) != 0xE0 || (PJOUT & 0x0F) != 0x0F) {
+        fprintf(stderr, "FAIL: P3.4 no longer outputs SMCLK or the LEDs are wrong\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    unsigned int isr_cycles = argc > 1 ? atoi(argv[1]) : DEFAULT_ISR_CYCLES;
+
+    if (isr_cycles < 10) {
+        fprintf(stderr, "usage: quadrature_decoder [ISR cycles]\n");
+        return 1;
+    }
+    if (check_table() || check_edge_rate(isr_cycles) || check_wrap() || check_clock_output()) return 1;
+    return 0;
+}
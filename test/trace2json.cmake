@@ -0,0 +1,48 @@
+# Simulate a TimerCapture.c run, decode it with trace2json and check the JSON.
+#
+# cmake -DCAPTURE=<trace_capture> -DDECODER=<trace2json> -DWORK=<dir> -P trace2json.cmake
+
+cmake_minimum_required(VERSION 3.19)
+
+execute_process(COMMAND ${CAPTURE} ${WORK}/capture.bin RESULT_VARIABLE status)
+if(NOT status EQUAL 0)
+  message(FATAL_ERROR "trace_capture failed: ${status}")
+endif()
+execute_process(COMMAND ${DECODER} ${WORK}/capture.bin OUTPUT_FILE ${WORK}/trace.json RESULT_VARIABLE status)
+if(NOT status EQUAL 0)
+  message(FATAL_ERROR "trace2json failed: ${status}")
+endif()
+
+file(READ ${WORK}/trace.json json)
+string(JSON count ERROR_VARIABLE error LENGTH "${json}" traceEvents)
+if(error)
+  message(FATAL_ERROR "trace.json is not valid: ${error}")
+endif()
+
+# 500 pulses of 1000 ticks, each about 2 ms after the last
+set(widths 0)
+set(last_ts -1)
+math(EXPR last "${count} - 1")
+foreach(index RANGE ${last})
+  string(JSON name GET "${json}" traceEvents ${index} name)
+  if(name STREQUAL "pulse width")
+    string(JSON ticks GET "${json}" traceEvents ${index} args "SMCLK ticks")
+    string(JSON ts GET "${json}" traceEvents ${index} ts)
+    if(NOT ticks EQUAL 1000)
+      message(FATAL_ERROR "pulse width ${ticks} ticks at ${ts} us, expected 1000")
+    endif()
+    string(REGEX REPLACE "\\..*" "" ts "${ts}")
+    if(last_ts GREATER_EQUAL 0)
+      math(EXPR gap "${ts} - ${last_ts}")
+      if(gap LESS 1984 OR gap GREATER 2016)
+        message(FATAL_ERROR "pulse widths ${gap} us apart at ${ts} us, expected 2000 (+-16)")
+      endif()
+    endif()
+    set(last_ts ${ts})
+    math(EXPR widths "${widths} + 1")
+  endif()
+endforeach()
+if(NOT widths EQUAL 500)
+  message(FATAL_ERROR "${widths} pulse widths decoded, expected 500")
+endif()
+message(STATUS "${count} trace events decoded, ${widths} pulse widths")
@@ -0,0 +1,92 @@
+// Runs TimerCapture.c against a simulated 500 Hz PWM input for one second,
+// with the UART TX interrupt paced at 115200 baud, and checks that the link
+// keeps up. The UART bytes go to the file named on the command line, for
+// tools/trace2json.
+
+#define main firmware_main
+#include "TimerCapture.c"
+#undef main
+
+#include <stdio.h>
+
+#define SMCLK_HZ 1000000UL
+#define UART_BAUD 115200UL                 // What TRACE_UART_BRW and TRACE_UART_MCTLW give at SMCLK_HZ
+#define PWM_PERIOD 2000                    // TB1CCR0 + 1
+#define PWM_HIGH 1000                      // TB1CCR1
+#define DURATION (SMCLK_HZ * 1)            // One second
+#define MAX_DROPPED_PERCENT 1
+
+int main(int argc, char **argv) {
+    unsigned long byte_ticks = 10 * SMCLK_HZ / UART_BAUD; // Start, 8 data and stop bits
+    unsigned long t = 0, next_edge = 0, uart_free = 0;
+    unsigned long edges = 0, widths = 0, reported_dropped = 0;
+    int rising = 1;
+
+    host_reset();
+    configure_timer_a_capture();
+    configure_UART();
+
+    TA1R = 0;
+    unsigned char i;
+    for (i = 0; i < 8; i++) trace(TRACE_COST, 0);
+    trace(TRACE_COST, 0);
+
+    while (t < DURATION) {
+        t = next_edge < uart_free ? next_edge : uart_free;
+        TA1R = (unsigned int)t;
+
+        if (t == next_edge) {
+            TA1CCR1 = (unsigned int)t;
+            if (rising) TA1CCTL1 |= CCI; else TA1CCTL1 &= ~CCI;
+            TA1CCTL1 |= CCIFG;
+            Timer_A_Capture_ISR();
+            if (!rising) widths++;
+            edges++;
+            next_edge += rising ? PWM_HIGH : PWM_PERIOD - PWM_HIGH;
+            rising = !rising;
+        }
+        trace_drain();                     // The main loop queues whatever fits
+        if (t >= uart_free) {
+            // The free UART takes the next queued byte; it stays free until the next edge if none
+            unsigned int sent = uart.stats.tx_bytes;
+            if (host_uart_vector(0) == USCI_UART_UCTXIFG) uart_ISR();
+            uart_free = uart.stats.tx_bytes != sent ? t + byte_ticks : next_edge;
+        }
+    }
+    host_uart_flush(0);
+
+    if (host_tx_count[0] > HOST_TX_LOG_SIZE) {
+        fprintf(stderr, "FAIL: the UART log overflowed after %lu bytes\n", host_tx_count[0]);
+        return 1;
+    }
+
+    // Count the drops the stream reports, plus any still waiting to be reported
+    unsigned long n;
+    for (n = 0; n + TRACE_PACKET_SIZE <= host_tx_count[0]; n++) {
+        if (host_tx_log[0][n] == START_BYTE && host_tx_log[0][n + 1] == TRACE_DROPPED) {
+            unsigned char escape = host_tx_log[0][n + 5];
+            reported_dropped += ((escape & 0x02) ? 0xFF00 : host_tx_log[0][n + 3] << 8) |
+                                ((escape & 0x04) ? 0xFF : host_tx_log[0][n + 4]);
+        }
+    }
+    unsigned long dropped = reported_dropped + trace_dropped;
+    unsigned long events = widths + (TRACE_ISR_EVENTS ? 2 * edges : 0);
+
+    printf("%lu edges, %lu events, %lu dropped (%.1f%%), %lu bytes on the link (%.0f%% busy)\n",
+           edges, events, dropped, 100.0 * dropped / events, host_tx_count[0],
+           100.0 * host_tx_count[0] * byte_ticks / DURATION);
+
+    if (argc > 1) {
+        FILE *out = fopen(argv[1], "wb");
+        if (!out || fwrite(host_tx_log[0], 1, host_tx_count[0], out) != host_tx_count[0]) {
+            perror(argv[1]);
+            return 1;
+        }
+        fclose(out);
+    }
+    if (dropped * 100 > events * MAX_DROPPED_PERCENT) {
+        fprintf(stderr, "FAIL: more than %u%% of the trace events were dropped\n", MAX_DROPPED_PERCENT);
+        return 1;
+    }
+    return 0;
+}
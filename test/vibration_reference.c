@@ -0,0 +1,157 @@
+// Checks the VibrationAnalysis.c fixed-point FFT and Goertzel detectors
+// against a double-precision DFT: random tones with noise, impulses, paired
+// full-scale dips and square waves, which push the butterfly sums to their
+// largest values. The host int is 32 bits, so each output is also checked to
+// fit the 16 bits it has on the MSP430, and the host long is 64 bits, so every
+// product and sum in goertzel() is checked to fit the 32 bits it has there.
+// Full-scale square waves at and around each detector bin drive the Goertzel
+// state to its largest values
+
+#include <stdint.h>
+
+// Largest magnitude of any goertzel() product or sum so far
+static long goertzel_term_max;
+
+static long goertzel_term(long value) {
+    long magnitude = value < 0 ? -value : value;
+    if (magnitude > goertzel_term_max) goertzel_term_max = magnitude;
+    return value;
+}
+
+#define GOERTZEL_TERM(value) goertzel_term(value)
+#define main firmware_main
+#include "VibrationAnalysis.c"
+#undef main
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FFT_TOLERANCE 8              // Q15 units of X[k] / FFT_SIZE (full scale 32768)
+#define GOERTZEL_TOLERANCE 0.03      // Relative, plus GOERTZEL_FLOOR for small powers
+#define GOERTZEL_FLOOR 50
+
+static double max_fft_error, max_goertzel_error;
+
+// Centre a block the way analyse_block does
+static void centre(const int *raw, int *centred) {
+    long mean = 0;
+    int i;
+    for (i = 0; i < FFT_SIZE; i++) mean += raw[i];
+    mean /= FFT_SIZE;
+    for (i = 0; i < FFT_SIZE; i++) centred[i] = raw[i] - mean;
+}
+
+static void reference_dft(const int *centred, int k, double *re, double *im) {
+    int n;
+    *re = *im = 0;
+    for (n = 0; n < FFT_SIZE; n++) {
+        *re += centred[n] * cos(2 * M_PI * k * n / FFT_SIZE);
+        *im -= centred[n] * sin(2 * M_PI * k * n / FFT_SIZE);
+    }
+}
+
+static int check_block(const char *name, const int *raw) {
+    int centred[FFT_SIZE], re[FFT_SIZE], im[FFT_SIZE];
+    double block_error = 0;
+    int i, d;
+
+    centre(raw, centred);
+    for (d = 0; d < DETECTOR_COUNT; d++) {
+        double ref_re, ref_im, reference, error;
+        unsigned int power = goertzel(centred, d);
+        reference_dft(centred, detector_bin[d], &ref_re, &ref_im);
+        reference = (ref_re * ref_re + ref_im * ref_im) / 4096;      // goertzel() scaling
+        reference = fmin(reference, 0xFFFF);                          // Saturates by design
+        error = fabs(power - reference) / (reference + GOERTZEL_FLOOR);
+        if (error > max_goertzel_error) max_goertzel_error = error;
+        if (error > GOERTZEL_TOLERANCE) {
+            fprintf(stderr, "FAIL: %s: detector %d power %u, reference %.1f\n", name, d, power, reference);
+            return 1;
+        }
+    }
+    if (goertzel_term_max > INT32_MAX) {
+        fprintf(stderr, "FAIL: %s: a goertzel() term reached %ld, past 32 bits\n", name, goertzel_term_max);
+        return 1;
+    }
+
+    for (i = 0; i < FFT_SIZE; i++) {
+        re[i] = centred[i] << INPUT_SHIFT;
+        im[i] = 0;
+    }
+    fft(re, im);
+    for (i = 0; i < FFT_SIZE; i++) {
+        double ref_re, ref_im, error;
+        reference_dft(centred, i, &ref_re, &ref_im);
+        ref_re *= (double)(1 << INPUT_SHIFT) / FFT_SIZE;
+        ref_im *= (double)(1 << INPUT_SHIFT) / FFT_SIZE;
+        if (re[i] < -32768 || re[i] > 32767 || im[i] < -32768 || im[i] > 32767) {
+            fprintf(stderr, "FAIL: %s: bin %d (%d, %d) does not fit in 16 bits\n", name, i, re[i], im[i]);
+            return 1;
+        }
+        error = fmax(fabs(re[i] - ref_re), fabs(im[i] - ref_im));
+        if (error > block_error) block_error = error;
+        if (error > FFT_TOLERANCE) {
+            fprintf(stderr, "FAIL: %s: bin %d is (%d, %d), reference (%.1f, %.1f)\n", name, i, re[i], im[i], ref_re, ref_im);
+            return 1;
+        }
+    }
+    if (block_error > max_fft_error) max_fft_error = block_error;
+    return 0;
+}
+
+int main(void) {
+    int raw[FFT_SIZE], i, t, d;
+
+    configure_detectors();
+
+    // A single 1023 sample on a 300 baseline: the spike is the whole block's energy
+    for (i = 0; i < FFT_SIZE; i++) raw[i] = 300;
+    raw[0] = 1023;
+    if (check_block("impulse at 0", raw)) return 1;
+    raw[0] = 300;
+    raw[37] = 1023;
+    if (check_block("impulse at 37", raw)) return 1;
+
+    // Two dips to 0 on a 1023 baseline, FFT_SIZE / 2 apart: the first stage adds
+    // them, and the sum needs 17 bits
+    for (i = 0; i < FFT_SIZE; i++) raw[i] = 1023;
+    raw[5] = raw[5 + FFT_SIZE / 2] = 0;
+    if (check_block("paired dips", raw)) return 1;
+
+    // Full-scale square waves at Nyquist and at bin 1
+    for (i = 0; i < FFT_SIZE; i++) raw[i] = (i & 1) ? 1023 : 0;
+    if (check_block("square at Nyquist", raw)) return 1;
+    for (i = 0; i < FFT_SIZE; i++) raw[i] = (i < FFT_SIZE / 2) ? 1023 : 0;
+    if (check_block("square at bin 1", raw)) return 1;
+
+    // Full-scale square waves at, between and around each detector bin, at a few phases
+    for (d = 0; d < DETECTOR_COUNT; d++) {
+        for (t = -2; t <= 2; t++) {
+            double cycles = detector_bin[d] + t / 4.0, phase;
+            for (phase = 0; phase < 2 * M_PI; phase += M_PI / 5) {
+                for (i = 0; i < FFT_SIZE; i++) {
+                    raw[i] = sin(2 * M_PI * cycles * i / FFT_SIZE + phase) >= 0 ? 1023 : 0;
+                }
+                if (check_block("square near a detector bin", raw)) return 1;
+            }
+        }
+    }
+
+    // Tones of random frequency and amplitude with noise, clipped to the ADC range
+    srand(3);
+    for (t = 0; t < 200; t++) {
+        double hz = rand() % (SAMPLE_HZ / 2), amplitude = 50 + rand() % 460;
+        for (i = 0; i < FFT_SIZE; i++) {
+            raw[i] = 512 + (int)(amplitude * sin(2 * M_PI * hz * i / SAMPLE_HZ)) + rand() % 21 - 10;
+            if (raw[i] < 0) raw[i] = 0;
+            if (raw[i] > 1023) raw[i] = 1023;
+        }
+        if (check_block("tone", raw)) return 1;
+    }
+
+    printf("FFT max error %.1f Q15 units (tolerance %d), Goertzel max relative error %.4f (tolerance %.2f), "
+           "largest Goertzel term %.2f x 2^31\n", max_fft_error, FFT_TOLERANCE, max_goertzel_error,
+           GOERTZEL_TOLERANCE, goertzel_term_max / 2147483648.0);
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Convert the TimerCapture.c trace stream to Chrome trace JSON, which loads in
+// chrome://tracing and ui.perfetto.dev.
+//
+//     trace2json [-m <SMCLK MHz>] [capture.bin] > trace.json
+//
+// Reads the raw UART bytes (a file or stdin). Each packet is START_BYTE, id,
+// delta, arg high, arg low, escape; a 0xFF data byte is sent as 0x00 with its
+// escape bit set (bit 0 = delta, bit 1 = arg high, bit 2 = arg low). Deltas
+// count 16 SMCLK ticks and 255 means "at least 255". Packets cut short by line
+// noise are skipped: a 0xFF inside a packet starts the next one.
+//
+// Capture ISR entry and exit become a duration slice, pulse widths a counter
+// track and the other events instant markers. A summary goes to stderr.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define START_BYTE 0xFF
+#define PACKET_SIZE 6
+#define TICK_SHIFT 4                       // TRACE_TICK_SHIFT in TimerCapture.c
+
+#define TRACE_CAPTURE_ENTER 1
+#define TRACE_CAPTURE_EXIT 2
+#define TRACE_PULSE_WIDTH 3
+#define TRACE_DROPPED 4
+#define TRACE_COST 5
+
+struct decoder {
+    double smclk_mhz;
+    double time_us;                        // Time of the latest event
+    unsigned long events;
+    unsigned long dropped;                 // Sum of TRACE_DROPPED arguments
+    unsigned long saturated;               // Deltas that hit 255, so the timeline is a lower bound
+    unsigned long skipped_bytes;           // Bytes discarded while resynchronizing
+    unsigned int open_slices;              // ISR entries without their exit yet
+    const char *separator;
+};
+
+// Print one trace event object
+static void emit(struct decoder *decoder, const char *format, ...) {
+    va_list args;
+    printf("%s\n    ", decoder->separator);
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    decoder->separator = ",";
+}
+
+static void decode_event(struct decoder *decoder, unsigned char id, unsigned char delta, unsigned int arg) {
+    double ts;
+
+    decoder->time_us += (double)(delta << TICK_SHIFT) / decoder->smclk_mhz;
+    if (delta == 255) decoder->saturated++;
+    decoder->events++;
+    ts = decoder->time_us;
+
+    switch (id) {
+        case TRACE_CAPTURE_ENTER:
+            emit(decoder, "{\"name\": \"capture ISR\", \"ph\": \"B\", \"ts\": %.3f, \"pid\": 1, \"tid\": 1, "
+                 "\"args\": {\"TA1CCTL1\": %u}}", ts, arg);
+            decoder->open_slices++;
+            break;
+        case TRACE_CAPTURE_EXIT:
+            if (decoder->open_slices == 0) break;  // Its entry was lost
+            emit(decoder, "{\"name\": \"capture ISR\", \"ph\": \"E\", \"ts\": %.3f, \"pid\": 1, \"tid\": 1, "
+                 "\"args\": {\"ring depth\": %u}}", ts, arg);
+            decoder->open_slices--;
+            break;
+        case TRACE_PULSE_WIDTH:
+            emit(decoder, "{\"name\": \"pulse width\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, "
+                 "\"args\": {\"SMCLK ticks\": %u}}", ts, arg);
+            break;
+        case TRACE_DROPPED:
+            decoder->dropped += arg;
+            emit(decoder, "{\"name\": \"dropped\", \"ph\": \"i\", \"s\": \"g\", \"ts\": %.3f, \"pid\": 1, \"tid\": 1, "
+                 "\"args\": {\"events\": %u}}", ts, arg);
+            break;
+        case TRACE_COST:
+            emit(decoder, "{\"name\": \"trace cost\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f, \"pid\": 1, \"tid\": 1, "
+                 "\"args\": {\"SMCLK ticks\": %u}}", ts, arg);
+            break;
+        default:
+            emit(decoder, "{\"name\": \"event %u\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f, \"pid\": 1, \"tid\": 1, "
+                 "\"args\": {\"arg\": %u}}", id, ts, arg);
+            break;
+    }
+}
+
+int main(int argc, char **argv) {
+    struct decoder decoder;
+    unsigned char packet[PACKET_SIZE];
+    unsigned int length = 0;
+    FILE *input = stdin;
+    int byte, i;
+
+    memset(&decoder, 0, sizeof(decoder));
+    decoder.smclk_mhz = 1.0;
+    decoder.separator = "";
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            decoder.smclk_mhz = atof(argv[++i]);
+        } else if (input == stdin) {
+            input = fopen(argv[i], "rb");
+            if (!input) {
+                perror(argv[i]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "usage: trace2json [-m <SMCLK MHz>] [capture.bin]\n");
+            return 1;
+        }
+    }
+    if (decoder.smclk_mhz <= 0) {
+        fprintf(stderr, "trace2json: SMCLK must be positive\n");
+        return 1;
+    }
+
+    printf("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    while ((byte = getc(input)) != EOF) {
+        if (byte == START_BYTE) {
+            decoder.skipped_bytes += length;   // A start byte always begins a new packet
+            length = 0;
+        } else if (length == 0) {
+            decoder.skipped_bytes++;           // Waiting for a start byte
+            continue;
+        }
+        packet[length++] = byte;
+        if (length < PACKET_SIZE) continue;
+        length = 0;
+
+        unsigned char escape = packet[5];
+        if (escape & ~0x07) {
+            decoder.skipped_bytes += PACKET_SIZE;
+            continue;
+        }
+        unsigned char delta = (escape & 0x01) ? 0xFF : packet[2];
+        unsigned int arg = ((escape & 0x02) ? 0xFF00 : (unsigned int)packet[3] << 8) |
+                           ((escape & 0x04) ? 0x00FF : packet[4]);
+        decode_event(&decoder, packet[1], delta, arg);
+    }
+    printf("\n]}\n");
+    decoder.skipped_bytes += length;
+
+    fprintf(stderr, "%lu events over %.3f s, %lu reported dropped, %lu saturated deltas, %lu bytes skipped\n",
+            decoder.events, decoder.time_us / 1e6, decoder.dropped, decoder.saturated, decoder.skipped_bytes);
+    if (input != stdin) fclose(input);
+    return 0;
+}